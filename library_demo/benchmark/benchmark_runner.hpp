@@ -0,0 +1,342 @@
+#ifndef BENCHMARK_RUNNER_HPP_
+#define BENCHMARK_RUNNER_HPP_
+
+// Headless benchmark shared by the *_benchmark programs. Every instance owns
+// one handle on its own thread and submits the same frames as fast as the
+// graph takes them, or at --fps. Results are printed as one JSON object per
+// instance followed by a summary object, one object per line:
+//
+//   face_mesh_benchmark --video face.mp4 --frames 600 --instances 2
+//   face_mesh_benchmark --synthetic 640x480 --frames 300 --fps 30
+//
+// Synthetic frames contain no face, hand or body, so they only measure the
+// detection path of a graph; use a video to measure tracking.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "mediapipe_library.h"
+
+// The C API of one interface.
+struct BenchmarkInterface {
+    const char* name_;
+    const char* default_graph_;
+    MpStatus (*create_)(const char* graph_name, const MpOptions* options, MpHandle* handle);
+    MpStatus (*start_)(MpHandle handle);
+    MpStatus (*process_image_at_)(MpHandle handle, const MpImage* image, long long timestamp_us,
+                                  frame_release_callback release, void* user_data);
+    MpStatus (*stop_)(MpHandle handle);
+    MpStatus (*stats_)(MpHandle handle, MpStats* stats);
+    MpStatus (*release_)(MpHandle handle);
+};
+
+struct BenchmarkArgs {
+    std::string graph_;
+    std::string video_;
+    int width_{640};
+    int height_{480};
+    int frames_{300};
+    int instances_{1};
+    // Input rate per instance; 0 submits as fast as the graph accepts.
+    double fps_{0.};
+    int offline_{1};
+    int warmup_frames_{2};
+    int num_threads_{0};
+    int inference_threads_{0};
+    int shared_executor_{0};
+    int work_stealing_{0};
+};
+
+struct ResourceUsage {
+    double user_s_{0.};
+    double system_s_{0.};
+    long long max_rss_kb_{0};
+};
+
+inline void PrintBenchmarkUsage(const BenchmarkInterface& interface) {
+    std::cerr << "usage: " << interface.name_ << "_benchmark [--video PATH | --synthetic WxH] [--frames N]\n"
+              << "       [--instances N] [--fps F] [--offline 0|1] [--warmup N] [--graph NAME]\n"
+              << "       [--threads N] [--inference-threads N] [--shared-executor 0|1] [--work-stealing 0|1]\n"
+              << "default graph: " << interface.default_graph_ << std::endl;
+}
+
+inline bool ParseBenchmarkArgs(int argc, char** argv, BenchmarkArgs* args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (flag == "--video") {
+            args->video_ = value;
+        } else if (flag == "--synthetic") {
+            if (std::sscanf(value.c_str(), "%dx%d", &args->width_, &args->height_) != 2) {
+                return false;
+            }
+        } else if (flag == "--frames") {
+            args->frames_ = std::atoi(value.c_str());
+        } else if (flag == "--instances") {
+            args->instances_ = std::atoi(value.c_str());
+        } else if (flag == "--fps") {
+            args->fps_ = std::atof(value.c_str());
+        } else if (flag == "--offline") {
+            args->offline_ = std::atoi(value.c_str());
+        } else if (flag == "--warmup") {
+            args->warmup_frames_ = std::atoi(value.c_str());
+        } else if (flag == "--graph") {
+            args->graph_ = value;
+        } else if (flag == "--threads") {
+            args->num_threads_ = std::atoi(value.c_str());
+        } else if (flag == "--inference-threads") {
+            args->inference_threads_ = std::atoi(value.c_str());
+        } else if (flag == "--shared-executor") {
+            args->shared_executor_ = std::atoi(value.c_str());
+        } else if (flag == "--work-stealing") {
+            args->work_stealing_ = std::atoi(value.c_str());
+        } else {
+            return false;
+        }
+    }
+    return args->frames_ > 0 && args->instances_ > 0 && args->width_ > 0 && args->height_ > 0;
+}
+
+// Decodes up to max_frames frames of the video, which the instances cycle
+// through, so that decoding never shows up in the measurement.
+inline bool LoadVideoFrames(const std::string& path, int max_frames, std::vector<cv::Mat>* frames) {
+    cv::VideoCapture capture(path);
+    if (!capture.isOpened()) {
+        return false;
+    }
+    cv::Mat frame;
+    while (static_cast<int>(frames->size()) < max_frames && capture.read(frame)) {
+        frames->push_back(frame.clone());
+    }
+    return !frames->empty();
+}
+
+// Deterministic frames with a moving gradient, so that consecutive frames
+// differ like camera input does.
+inline void MakeSyntheticFrames(int width, int height, int count, std::vector<cv::Mat>* frames) {
+    for (int i = 0; i < count; ++i) {
+        cv::Mat frame(height, width, CV_8UC3);
+        for (int y = 0; y < height; ++y) {
+            auto* row = frame.ptr<unsigned char>(y);
+            for (int x = 0; x < width; ++x) {
+                row[3 * x] = static_cast<unsigned char>(x + 4 * i);
+                row[3 * x + 1] = static_cast<unsigned char>(y + 2 * i);
+                row[3 * x + 2] = static_cast<unsigned char>(x + y + i);
+            }
+        }
+        frames->push_back(frame);
+    }
+}
+
+inline ResourceUsage GetResourceUsage() {
+    ResourceUsage usage;
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        auto seconds = [](const FILETIME& time) {
+            return ((static_cast<unsigned long long>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+        };
+        usage.user_s_ = seconds(user);
+        usage.system_s_ = seconds(kernel);
+    }
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.max_rss_kb_ = counters.PeakWorkingSetSize / 1024;
+    }
+#else
+    rusage self{};
+    if (getrusage(RUSAGE_SELF, &self) == 0) {
+        usage.user_s_ = self.ru_utime.tv_sec + self.ru_utime.tv_usec / 1e6;
+        usage.system_s_ = self.ru_stime.tv_sec + self.ru_stime.tv_usec / 1e6;
+#ifdef __APPLE__
+        usage.max_rss_kb_ = self.ru_maxrss / 1024;
+#else
+        usage.max_rss_kb_ = self.ru_maxrss;
+#endif
+    }
+#endif
+    return usage;
+}
+
+struct InstanceResult {
+    MpStatus status_{MP_OK};
+    std::string error_;
+    int submitted_{0};
+    int rejected_{0};
+    double wall_s_{0.};
+    MpStats stats_{};
+};
+
+// The frames are shared by every instance and never modified, so they are
+// lent to the graph without a copy.
+inline void ReleaseNothing(unsigned char*, void*) {}
+
+inline void RunInstance(const BenchmarkInterface& interface, const BenchmarkArgs& args,
+                        const std::vector<cv::Mat>& frames, std::atomic<int>* ready, std::atomic<bool>* go,
+                        InstanceResult* result) {
+    MpOptions options{};
+    options.offline_ = args.offline_;
+    options.warmup_frames_ = args.warmup_frames_;
+    options.warmup_width_ = frames[0].cols;
+    options.warmup_height_ = frames[0].rows;
+    options.num_threads_ = args.num_threads_;
+    options.inference_threads_ = args.inference_threads_;
+    options.shared_executor_ = args.shared_executor_;
+    options.work_stealing_ = args.work_stealing_;
+    MpHandle handle = nullptr;
+    auto fail = [&](MpStatus status) {
+        result->status_ = status;
+        result->error_ = GetLastErrorMessage();
+    };
+    auto graph = args.graph_.empty() ? std::string(interface.default_graph_) : args.graph_;
+    MpStatus status = interface.create_(graph.c_str(), &options, &handle);
+    if (status == MP_OK) {
+        status = interface.start_(handle);
+    }
+    // Every instance starts submitting together, after all models are loaded.
+    ready->fetch_sub(1);
+    while (!go->load()) {
+        std::this_thread::yield();
+    }
+    if (status != MP_OK) {
+        fail(status);
+        if (handle) {
+            interface.release_(handle);
+        }
+        return;
+    }
+    auto interval = args.fps_ > 0. ? std::chrono::duration<double>(1. / args.fps_) : std::chrono::duration<double>(0.);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < args.frames_; ++i) {
+        if (args.fps_ > 0.) {
+            std::this_thread::sleep_until(begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * i));
+        }
+        const auto& frame = frames[i % frames.size()];
+        MpImage image{frame.data, frame.cols, frame.rows, static_cast<int>(frame.step), IMAGE_BGR};
+        // Spaced like 30 fps video, whatever the actual submission rate.
+        status = interface.process_image_at_(handle, &image, i * 33333LL, ReleaseNothing, nullptr);
+        if (status == MP_OK) {
+            ++result->submitted_;
+        } else if (status == MP_UNAVAILABLE) {
+            ++result->rejected_;
+        } else {
+            fail(status);
+            break;
+        }
+    }
+    status = interface.stop_(handle);
+    result->wall_s_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (status != MP_OK && result->status_ == MP_OK) {
+        fail(status);
+    }
+    interface.stats_(handle, &result->stats_);
+    interface.release_(handle);
+}
+
+inline std::string JsonString(const std::string& value) {
+    std::string escaped = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c == '\n' ? ' ' : c;
+    }
+    return escaped + "\"";
+}
+
+inline int RunBenchmark(const BenchmarkInterface& interface, int argc, char** argv) {
+    BenchmarkArgs args;
+    if (!ParseBenchmarkArgs(argc, argv, &args)) {
+        PrintBenchmarkUsage(interface);
+        return 2;
+    }
+    std::vector<cv::Mat> frames;
+    if (!args.video_.empty()) {
+        if (!LoadVideoFrames(args.video_, std::min(args.frames_, 120), &frames)) {
+            std::cerr << "cannot read " << args.video_ << std::endl;
+            return 2;
+        }
+    } else {
+        MakeSyntheticFrames(args.width_, args.height_, std::min(args.frames_, 30), &frames);
+    }
+
+    std::vector<InstanceResult> results(args.instances_);
+    std::vector<std::thread> threads;
+    std::atomic<int> ready{args.instances_};
+    std::atomic<bool> go{false};
+    for (int i = 0; i < args.instances_; ++i) {
+        threads.emplace_back(RunInstance, std::cref(interface), std::cref(args), std::cref(frames), &ready, &go, &results[i]);
+    }
+    while (ready.load() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // CPU time is counted from here, so model loading and warm-up are left out.
+    auto usage_before = GetResourceUsage();
+    go = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto usage_after = GetResourceUsage();
+
+    int exit_code = 0;
+    double total_fps = 0.;
+    double wall_s = 0.;
+    unsigned long long frames_out = 0;
+    for (int i = 0; i < args.instances_; ++i) {
+        const auto& result = results[i];
+        const auto& stats = result.stats_;
+        std::ostringstream line;
+        line << "{\"interface\":" << JsonString(interface.name_) << ",\"instance\":" << i;
+        if (result.status_ != MP_OK) {
+            exit_code = 1;
+            line << ",\"status\":" << result.status_ << ",\"error\":" << JsonString(result.error_);
+        }
+        double fps = result.wall_s_ > 0. ? stats.frames_out_ / result.wall_s_ : 0.;
+        line << ",\"submitted\":" << result.submitted_ << ",\"rejected\":" << result.rejected_
+             << ",\"frames_out\":" << stats.frames_out_ << ",\"frames_dropped\":" << stats.frames_dropped_
+             << ",\"wall_s\":" << result.wall_s_ << ",\"fps\":" << fps
+             << ",\"latency_p50_us\":" << stats.latency_p50_us_ << ",\"latency_p90_us\":" << stats.latency_p90_us_
+             << ",\"latency_p99_us\":" << stats.latency_p99_us_ << ",\"startup_us\":"
+             << stats.startup_.load_us_ + stats.startup_.parse_us_ + stats.startup_.initialize_us_ + stats.startup_.start_us_
+             << ",\"warmup_us\":" << stats.startup_.warmup_us_ << ",\"executor_cpu_us\":" << stats.executor_cpu_us_
+             << "}";
+        std::cout << line.str() << std::endl;
+        total_fps += fps;
+        wall_s = std::max(wall_s, result.wall_s_);
+        frames_out += stats.frames_out_;
+    }
+    double cpu_s = (usage_after.user_s_ - usage_before.user_s_) + (usage_after.system_s_ - usage_before.system_s_);
+    std::cout << "{\"interface\":" << JsonString(interface.name_) << ",\"summary\":true"
+              << ",\"source\":" << JsonString(args.video_.empty() ? "synthetic" : args.video_)
+              << ",\"width\":" << frames[0].cols << ",\"height\":" << frames[0].rows
+              << ",\"instances\":" << args.instances_ << ",\"frames_out\":" << frames_out
+              << ",\"wall_s\":" << wall_s << ",\"fps\":" << total_fps
+              << ",\"cpu_user_s\":" << usage_after.user_s_ - usage_before.user_s_
+              << ",\"cpu_system_s\":" << usage_after.system_s_ - usage_before.system_s_
+              << ",\"cpu_ms_per_frame\":" << (frames_out > 0 ? 1e3 * cpu_s / frames_out : 0.)
+              << ",\"max_rss_kb\":" << usage_after.max_rss_kb_ << "}" << std::endl;
+    return exit_code;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"face_blendshape",
+                                       "embedded:face_blendshape",
+                                       CreateFaceBlendShapeInterface,
+                                       StartFaceBlendShape,
+                                       FaceBlendShapeProcessImageAt,
+                                       StopFaceBlendShape,
+                                       GetFaceBlendShapeStats,
+                                       ReleaseFaceBlendShapeInterface};
+    return RunBenchmark(interface, argc, argv);
+}
@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"face_mesh",
+                                       "embedded:face_mesh",
+                                       CreateFaceMeshInterface,
+                                       StartFaceMesh,
+                                       FaceMeshProcessImageAt,
+                                       StopFaceMesh,
+                                       GetFaceMeshStats,
+                                       ReleaseFaceMeshInterface};
+    return RunBenchmark(interface, argc, argv);
+}
@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"face_mesh_blendshape",
+                                       "embedded:face_mesh_blendshape",
+                                       CreateFaceMeshBlendShapeInterface,
+                                       StartFaceMeshBlendShape,
+                                       FaceMeshBlendShapeProcessImageAt,
+                                       StopFaceMeshBlendShape,
+                                       GetFaceMeshBlendShapeStats,
+                                       ReleaseFaceMeshBlendShapeInterface};
+    return RunBenchmark(interface, argc, argv);
+}
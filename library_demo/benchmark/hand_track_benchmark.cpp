@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"hand_track",
+                                       "embedded:hand_tracking",
+                                       CreateHandTrackInterface,
+                                       StartHandTrack,
+                                       HandTrackProcessImageAt,
+                                       StopHandTrack,
+                                       GetHandTrackStats,
+                                       ReleaseHandTrackInterface};
+    return RunBenchmark(interface, argc, argv);
+}
@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"holistic_track",
+                                       "embedded:holistic_tracking",
+                                       CreateHolisticTrackInterface,
+                                       StartHolisticTrack,
+                                       HolisticTrackProcessImageAt,
+                                       StopHolisticTrack,
+                                       GetHolisticTrackStats,
+                                       ReleaseHolisticTrackInterface};
+    return RunBenchmark(interface, argc, argv);
+}
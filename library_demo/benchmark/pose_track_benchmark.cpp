@@ -0,0 +1,13 @@
+#include "benchmark_runner.hpp"
+
+int main(int argc, char** argv) {
+    const BenchmarkInterface interface{"pose_track",
+                                       "embedded:pose_tracking",
+                                       CreatePoseTrackInterface,
+                                       StartPoseTrack,
+                                       PoseTrackProcessImageAt,
+                                       StopPoseTrack,
+                                       GetPoseTrackStats,
+                                       ReleasePoseTrackInterface};
+    return RunBenchmark(interface, argc, argv);
+}
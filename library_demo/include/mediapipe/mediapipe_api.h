@@ -15,58 +15,171 @@
 extern "C" {
 #endif
 
-
 #include "mediapipe_struct.h"
 
-LibraryExport void CreateFaceMeshInterface(const char* graph_name);
-LibraryExport void ReleaseFaceMeshInterface();
-LibraryExport void StartFaceMesh();
-LibraryExport void FaceMeshProcess(void* mat);
-LibraryExport void SetFaceMeshObserveCallback(landmark_callback callback);
-LibraryExport void ObserveFaceMesh();
-LibraryExport void AddFaceMeshPoller();
-LibraryExport void GetFaceMeshOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
-LibraryExport void StopFaceMesh();
+// Every call returns an MpStatus and never throws; GetLastErrorMessage
+// describes the latest failure on the calling thread.
+//
+// Every Create*Interface call stores an independent handle that must be
+// passed back to the matching Release*Interface call. graph_name is a text
+// .pbtxt file, a binary .binarypb file, or "embedded:<name>" for one of the
+// headless graphs built into the library: face_mesh, hand_tracking,
+// pose_tracking, holistic_tracking, face_blendshape and face_mesh_blendshape.
+// CompileGraph converts any of them to a .binarypb with every subgraph
+// expanded, which loads fastest. MpOptions.warmup_frames_ makes Start run
+// the models once before returning; MpStats.startup_ reports each phase.
+// Several handles in one process should cap num_threads_ and
+// inference_threads_, or share one executor, to avoid oversubscribing cores.
+//
+// *Process copies an RGB cv::Mat into a pooled frame, so the caller may reuse
+// the Mat right away. *ProcessImage takes any MpImageFormat without a color
+// conversion pass. With a release callback the buffer is submitted without a
+// copy and must stay valid and unmodified until release is called; with a null
+// release it is copied before the call returns. A null buffer, a non-positive
+// or (for NV12 and I420) odd size, a width_step_ shorter than a row, or an
+// unknown format_ is rejected with MP_INVALID_ARGUMENT, and release is not
+// called.
+// *ProcessImageAt stamps the frame with the caller's microsecond timestamp,
+// which must increase strictly; the other calls stamp on submission.
+// The process calls return MP_UNAVAILABLE when the submission queue dropped
+// the frame, per MpOptions.drop_policy_. Get*QueueStats reports the accepted,
+// dropped, queued and in-flight frame counts.
+// Get*Stats reports frame rates, end-to-end latency percentiles, frames lost
+// anywhere in the graph and, with MpOptions.enable_profiler_, the slowest
+// calculators. It is cheap enough to poll while running and may be called from
+// any thread.
+//
+// TryGet*Latest waits at most timeout_us (0 polls) for a result newer than
+// the last one read and copies the newest result only; older ones are skipped.
+// It stores the number of values written in *written, 0 for a frame without
+// detections, and returns MP_UNAVAILABLE when nothing new arrived. Faces and
+// hands are packed one after another.
+// It never blocks on the *Poller queues and needs no prior setup call.
+//
+// Observe* registers the callbacks set beforehand and must precede Start*.
+// The landmark callbacks receive the first face or hand only; the result
+// callbacks receive every instance of a frame at once. The holistic result
+// callback receives pose, face and both hands of a frame in a single call.
+//
+// RecordTrace appends the results of every frame of any handle to a trace
+// file, which stores each result kind as a fixed-stride float column next to
+// the frame timestamps and a presence bit per slot. It must precede Start*,
+// and the file is complete once Stop* returns. Landmark lists are cut or
+// zero-padded to the channel's size; only the first face is kept.
+// OpenTrace maps a trace into memory for random access without parsing:
+// FindTraceFrame looks up a timestamp, GetTraceValues returns one slot of one
+// frame, or null when the slot was empty, and GetTraceColumn a run of
+// consecutive frames of one channel, up to the end of their block. Every
+// pointer returned stays valid until CloseTrace.
+//
+// The FaceMeshBlendShape interface runs face detection and the landmark model
+// once per frame and reports the first face's landmarks together with its
+// blendshapes, where a FaceMesh and a FaceBlendShape handle would each run
+// them. Use it with the embedded face_mesh_blendshape graph.
+
+LibraryExport const char* GetLastErrorMessage();
+LibraryExport MpStatus CompileGraph(const char* graph_name, const char* output_path);
+
+LibraryExport MpStatus RecordTrace(MpHandle handle, const char* path);
+LibraryExport MpStatus OpenTrace(const char* path, MpTraceHandle* trace);
+LibraryExport MpStatus CloseTrace(MpTraceHandle trace);
+LibraryExport MpStatus GetTraceInfo(MpTraceHandle trace, MpTraceInfo* info);
+LibraryExport MpStatus GetTraceChannel(MpTraceHandle trace, unsigned channel, MpTraceChannel* info);
+LibraryExport MpStatus FindTraceFrame(MpTraceHandle trace, long long timestamp_us, unsigned long long* index);
+LibraryExport MpStatus GetTraceTimestamp(MpTraceHandle trace, unsigned long long index, long long* timestamp_us);
+LibraryExport MpStatus GetTraceValues(MpTraceHandle trace, unsigned long long index, unsigned channel, unsigned slot, const float** values);
+LibraryExport MpStatus GetTraceColumn(MpTraceHandle trace, unsigned long long index, unsigned channel, const long long** timestamps, const float** values, unsigned long long* count);
+
+LibraryExport MpStatus CreateFaceMeshInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleaseFaceMeshInterface(MpHandle handle);
+LibraryExport MpStatus StartFaceMesh(MpHandle handle);
+LibraryExport MpStatus FaceMeshProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus FaceMeshProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus FaceMeshProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetFaceMeshObserveCallback(MpHandle handle, landmark_callback callback, void* user_data);
+LibraryExport MpStatus SetFaceMeshResultCallback(MpHandle handle, landmark_result_callback callback, void* user_data);
+LibraryExport MpStatus ObserveFaceMesh(MpHandle handle);
+LibraryExport MpStatus AddFaceMeshPoller(MpHandle handle);
+LibraryExport MpStatus GetFaceMeshOutput(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size);
+LibraryExport MpStatus TryGetFaceMeshLatest(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size, long long timeout_us, unsigned* written, long long* timestamp_us);
+LibraryExport MpStatus StopFaceMesh(MpHandle handle);
+LibraryExport MpStatus GetFaceMeshQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetFaceMeshStats(MpHandle handle, MpStats* stats);
+
+LibraryExport MpStatus CreateHandTrackInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleaseHandTrackInterface(MpHandle handle);
+LibraryExport MpStatus StartHandTrack(MpHandle handle);
+LibraryExport MpStatus HandTrackProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus HandTrackProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus HandTrackProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetHandTrackObserveCallback(MpHandle handle, landmark_callback callback, void* user_data);
+LibraryExport MpStatus SetHandTrackResultCallback(MpHandle handle, landmark_result_callback callback, void* user_data);
+LibraryExport MpStatus ObserveHandTrack(MpHandle handle);
+LibraryExport MpStatus AddHandTrackPoller(MpHandle handle);
+LibraryExport MpStatus GetHandTrackOutput(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size);
+LibraryExport MpStatus TryGetHandTrackLatest(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size, long long timeout_us, unsigned* written, long long* timestamp_us);
+LibraryExport MpStatus StopHandTrack(MpHandle handle);
+LibraryExport MpStatus GetHandTrackQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetHandTrackStats(MpHandle handle, MpStats* stats);
 
-LibraryExport void CreateHandTrackInterface(const char* graph_name);
-LibraryExport void ReleaseHandTrackInterface();
-LibraryExport void StartHandTrack();
-LibraryExport void HandTrackProcess(void* mat);
-LibraryExport void SetHandTrackObserveCallback(landmark_callback callback);
-LibraryExport void ObserveHandTrack();
-LibraryExport void AddHandTrackPoller();
-LibraryExport void GetHandTrackOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
-LibraryExport void StopHandTrack();
+LibraryExport MpStatus CreatePoseTrackInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleasePoseTrackInterface(MpHandle handle);
+LibraryExport MpStatus StartPoseTrack(MpHandle handle);
+LibraryExport MpStatus PoseTrackProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus PoseTrackProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus PoseTrackProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetPoseTrackObserveCallback(MpHandle handle, landmark_callback callback, void* user_data);
+LibraryExport MpStatus SetPoseTrackResultCallback(MpHandle handle, landmark_result_callback callback, void* user_data);
+LibraryExport MpStatus ObservePoseTrack(MpHandle handle);
+LibraryExport MpStatus AddPoseTrackPoller(MpHandle handle);
+LibraryExport MpStatus GetPoseTrackOutput(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size);
+LibraryExport MpStatus TryGetPoseTrackLatest(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned size, long long timeout_us, unsigned* written, long long* timestamp_us);
+LibraryExport MpStatus StopPoseTrack(MpHandle handle);
+LibraryExport MpStatus GetPoseTrackQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetPoseTrackStats(MpHandle handle, MpStats* stats);
 
-LibraryExport void CreatePoseTrackInterface(const char* graph_name);
-LibraryExport void ReleasePoseTrackInterface();
-LibraryExport void StartPoseTrack();
-LibraryExport void PoseTrackProcess(void* mat);
-LibraryExport void SetPoseTrackObserveCallback(landmark_callback callback);
-LibraryExport void ObservePoseTrack();
-LibraryExport void AddPoseTrackPoller();
-LibraryExport void GetPoseTrackOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
-LibraryExport void StopPoseTrack();
+LibraryExport MpStatus CreateHolisticTrackInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleaseHolisticTrackInterface(MpHandle handle);
+LibraryExport MpStatus StartHolisticTrack(MpHandle handle);
+LibraryExport MpStatus HolisticTrackProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus HolisticTrackProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus HolisticTrackProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetHolisticTrackObserveCallback(MpHandle handle, landmark_callback callback, HolisticCallbackType type, void* user_data);
+LibraryExport MpStatus SetHolisticTrackResultCallback(MpHandle handle, holistic_result_callback callback, void* user_data);
+LibraryExport MpStatus ObserveHolisticTrack(MpHandle handle);
+// LibraryExport void AddHolisticTrackPoller(MpHandle handle);
+// LibraryExport void GetHolisticTrackOutput(MpHandle handle);
+LibraryExport MpStatus StopHolisticTrack(MpHandle handle);
+LibraryExport MpStatus GetHolisticTrackQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetHolisticTrackStats(MpHandle handle, MpStats* stats);
 
-LibraryExport void CreateHolisticTrackInterface(const char* graph_name);
-LibraryExport void ReleaseHolisticTrackInterface();
-LibraryExport void StartHolisticTrack();
-LibraryExport void HolisticTrackProcess(void* mat);
-LibraryExport void SetHolisticTrackObserveCallback(landmark_callback callback, HolisticCallbackType type);
-LibraryExport void ObserveHolisticTrack();
-// LibraryExport void AddHolisticTrackPoller();
-// LibraryExport void GetHolisticTrackOutput();
-LibraryExport void StopHolisticTrack();
+LibraryExport MpStatus CreateFaceBlendShapeInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleaseFaceBlendShapeInterface(MpHandle handle);
+LibraryExport MpStatus StartFaceBlendShape(MpHandle handle);
+LibraryExport MpStatus FaceBlendShapeProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus FaceBlendShapeProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus FaceBlendShapeProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetFaceBlendShapeCallback(MpHandle handle, blend_shape_callback callback, void* user_data);
+LibraryExport MpStatus ObserveFaceBlendShape(MpHandle handle);
+LibraryExport MpStatus AddFaceBlendShapePoller(MpHandle handle);
+LibraryExport MpStatus GetFaceBlendShapeOutput(MpHandle handle, float* blend_shape_list, unsigned size);
+LibraryExport MpStatus TryGetFaceBlendShapeLatest(MpHandle handle, float* blend_shape_list, unsigned size, long long timeout_us, unsigned* written, long long* timestamp_us);
+LibraryExport MpStatus StopFaceBlendShape(MpHandle handle);
+LibraryExport MpStatus GetFaceBlendShapeQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetFaceBlendShapeStats(MpHandle handle, MpStats* stats);
 
-LibraryExport void CreateFaceBlendShapeInterface(const char* graph_name);
-LibraryExport void ReleaseFaceBlendShapeInterface();
-LibraryExport void StartFaceBlendShape();
-LibraryExport void FaceBlendShapeProcess(void* mat);
-LibraryExport void SetFaceBlendShapeCallback(blend_shape_callback callback);
-LibraryExport void ObserveFaceBlendShape();
-LibraryExport void AddFaceBlendShapePoller();
-LibraryExport void GetFaceBlendShapeOutput(float* blend_shape_list, size_t size);
-LibraryExport void StopFaceBlendShape();
+LibraryExport MpStatus CreateFaceMeshBlendShapeInterface(const char* graph_name, const MpOptions* options, MpHandle* handle);
+LibraryExport MpStatus ReleaseFaceMeshBlendShapeInterface(MpHandle handle);
+LibraryExport MpStatus StartFaceMeshBlendShape(MpHandle handle);
+LibraryExport MpStatus FaceMeshBlendShapeProcess(MpHandle handle, void* mat);
+LibraryExport MpStatus FaceMeshBlendShapeProcessImage(MpHandle handle, const MpImage* image, frame_release_callback release, void* user_data);
+LibraryExport MpStatus FaceMeshBlendShapeProcessImageAt(MpHandle handle, const MpImage* image, long long timestamp_us, frame_release_callback release, void* user_data);
+LibraryExport MpStatus SetFaceMeshBlendShapeResultCallback(MpHandle handle, face_result_callback callback, void* user_data);
+LibraryExport MpStatus ObserveFaceMeshBlendShape(MpHandle handle);
+LibraryExport MpStatus TryGetFaceMeshBlendShapeLatest(MpHandle handle, NormalizedLandmark* normalized_landmark_list, unsigned landmark_size, float* blend_shape_list, unsigned blend_shape_size, long long timeout_us, unsigned* landmarks_written, unsigned* blend_shapes_written, long long* timestamp_us);
+LibraryExport MpStatus StopFaceMeshBlendShape(MpHandle handle);
+LibraryExport MpStatus GetFaceMeshBlendShapeQueueStats(MpHandle handle, MpQueueStats* stats);
+LibraryExport MpStatus GetFaceMeshBlendShapeStats(MpHandle handle, MpStats* stats);
 
 #ifdef __cplusplus
 }
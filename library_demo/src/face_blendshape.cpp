@@ -17,7 +17,7 @@ cv::Mat camera_bgr_frame;
 float *blend_shape_list = nullptr;
 int blend_shape_size = 0;
 
-void BlendShapeCallback(float *blend_shapes, size_t size) {
+void BlendShapeCallback(float *blend_shapes, unsigned size, void *user_data) {
     blend_shape_size = size;
     blend_shape_list = new float[size];
     memcpy(blend_shape_list, blend_shapes, sizeof(float) * size);
@@ -30,7 +30,11 @@ void BlendShapeCallback(float *blend_shapes, size_t size) {
 const std::string GRAPH_PATH = "mediapipe/graphs/face_blendshape/face_blendshape_desktop_live.pbtxt";
 
 int main() {
-    CreateFaceBlendShapeInterface(GRAPH_PATH.c_str());
+    MpHandle handle = nullptr;
+    if (CreateFaceBlendShapeInterface(GRAPH_PATH.c_str(), nullptr, &handle) != MP_OK) {
+        std::cout << GetLastErrorMessage() << std::endl;
+        return -1;
+    }
 
     cv::namedWindow("MediaPipeLibrary");
     cv::VideoCapture capture;
@@ -44,11 +48,11 @@ int main() {
         return -1;
     }
 
-    SetFaceBlendShapeCallback(BlendShapeCallback);
+    SetFaceBlendShapeCallback(handle, BlendShapeCallback, nullptr);
 
-    ObserveFaceBlendShape();
+    ObserveFaceBlendShape(handle);
 
-    StartFaceBlendShape();
+    StartFaceBlendShape(handle);
 
     while (grab_frame) {
         capture >> camera_bgr_frame;
@@ -58,9 +62,8 @@ int main() {
         if (camera_bgr_frame.empty()) {
             break;
         }
-        cv::Mat camera_rgb_frame;
-        cv::cvtColor(camera_bgr_frame, camera_rgb_frame, cv::COLOR_BGR2RGB);
-        FaceBlendShapeProcess(&camera_rgb_frame);
+        MpImage image{camera_bgr_frame.data, camera_bgr_frame.cols, camera_bgr_frame.rows, static_cast<int>(camera_bgr_frame.step), IMAGE_BGR};
+        FaceBlendShapeProcessImage(handle, &image, nullptr, nullptr);
 
         // if (camera_bgr_frame.cols > 0) {
             // for (int i = 0; i < blend_shape_size; ++i) {
@@ -73,8 +76,8 @@ int main() {
         int pressed_key = cv::waitKey(30);
         if (pressed_key >= 0 && pressed_key != 255) grab_frame = false;
     }
-    StopFaceBlendShape();
-    ReleaseFaceBlendShapeInterface();
+    StopFaceBlendShape(handle);
+    ReleaseFaceBlendShapeInterface(handle);
 
     _CrtDumpMemoryLeaks();
 
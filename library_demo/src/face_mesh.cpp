@@ -17,7 +17,7 @@ cv::Mat camera_bgr_frame;
 NormalizedLandmark *landmark_lists = nullptr;
 int landmark_lists_size = 0;
 
-void LandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
+void LandmarkCallback(NormalizedLandmark *normalized_landmark_lists, unsigned size, void *user_data) {
     int width = camera_bgr_frame.cols;
     int height = camera_bgr_frame.rows;
     landmark_lists_size = size;
@@ -33,7 +33,11 @@ void LandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size
 const std::string GRAPH_PATH = "mediapipe/graphs/face_mesh/face_mesh_desktop_live.pbtxt";
 
 int main() {
-    CreateFaceMeshInterface(GRAPH_PATH.c_str());
+    MpHandle handle = nullptr;
+    if (CreateFaceMeshInterface(GRAPH_PATH.c_str(), nullptr, &handle) != MP_OK) {
+        std::cout << GetLastErrorMessage() << std::endl;
+        return -1;
+    }
 
     cv::namedWindow("MediaPipeLibrary");
     cv::VideoCapture capture;
@@ -47,11 +51,11 @@ int main() {
         return -1;
     }
 
-    SetFaceMeshObserveCallback(LandmarkCallback);
+    SetFaceMeshObserveCallback(handle, LandmarkCallback, nullptr);
 
-    ObserveFaceMesh();
+    ObserveFaceMesh(handle);
 
-    StartFaceMesh();
+    StartFaceMesh(handle);
 
     while (grab_frame) {
         capture >> camera_bgr_frame;
@@ -61,9 +65,8 @@ int main() {
         if (camera_bgr_frame.empty()) {
             break;
         }
-        cv::Mat camera_rgb_frame;
-        cv::cvtColor(camera_bgr_frame, camera_rgb_frame, cv::COLOR_BGR2RGB);
-        FaceMeshProcess(&camera_rgb_frame);
+        MpImage image{camera_bgr_frame.data, camera_bgr_frame.cols, camera_bgr_frame.rows, static_cast<int>(camera_bgr_frame.step), IMAGE_BGR};
+        FaceMeshProcessImage(handle, &image, nullptr, nullptr);
 
         if (camera_bgr_frame.cols > 0) {
             for (int i = 0; i < landmark_lists_size; ++i) {
@@ -77,8 +80,8 @@ int main() {
         int pressed_key = cv::waitKey(30);
         if (pressed_key >= 0 && pressed_key != 255) grab_frame = false;
     }
-    StopFaceMesh();
-    ReleaseFaceMeshInterface();
+    StopFaceMesh(handle);
+    ReleaseFaceMeshInterface(handle);
 
     _CrtDumpMemoryLeaks();
 
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+
+#include "mediapipe_library.h"
+
+cv::Mat camera_bgr_frame;
+
+void FaceResultCallback(const MpFaceResult *result, void *user_data) {
+    if (!result->present_) {
+        return;
+    }
+    // Landmarks and blendshapes of a frame arrive together, so no matching by
+    // timestamp is needed.
+    std::cout << result->timestamp_us_ << ": " << result->landmark_count_ << " landmarks, blendshapes ";
+    for (unsigned i = 0; i < result->blend_shape_count_; ++i) {
+        std::cout << result->blend_shapes_[i] << " ";
+    }
+    std::cout << std::endl;
+}
+
+const std::string GRAPH_PATH = "embedded:face_mesh_blendshape";
+
+int main() {
+    MpHandle handle = nullptr;
+    if (CreateFaceMeshBlendShapeInterface(GRAPH_PATH.c_str(), nullptr, &handle) != MP_OK) {
+        std::cout << GetLastErrorMessage() << std::endl;
+        return -1;
+    }
+
+    cv::namedWindow("MediaPipeLibrary");
+    cv::VideoCapture capture;
+    capture.open(0);
+    bool is_camera = true;
+
+    bool grab_frame = true;
+    if (!capture.isOpened()) {
+        return -1;
+    }
+
+    SetFaceMeshBlendShapeResultCallback(handle, FaceResultCallback, nullptr);
+
+    ObserveFaceMeshBlendShape(handle);
+
+    StartFaceMeshBlendShape(handle);
+
+    while (grab_frame) {
+        capture >> camera_bgr_frame;
+        if (is_camera) {
+            cv::flip(camera_bgr_frame, camera_bgr_frame, 1);
+        }
+        if (camera_bgr_frame.empty()) {
+            break;
+        }
+        MpImage image{camera_bgr_frame.data, camera_bgr_frame.cols, camera_bgr_frame.rows, static_cast<int>(camera_bgr_frame.step), IMAGE_BGR};
+        FaceMeshBlendShapeProcessImage(handle, &image, nullptr, nullptr);
+
+        cv::imshow("MediaPipeLibrary", camera_bgr_frame);
+        int pressed_key = cv::waitKey(30);
+        if (pressed_key >= 0 && pressed_key != 255) grab_frame = false;
+    }
+    StopFaceMeshBlendShape(handle);
+    ReleaseFaceMeshBlendShapeInterface(handle);
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <thread>
@@ -10,16 +11,16 @@
 
 cv::Mat camera_bgr_frame;
 
-NormalizedLandmark *landmark_lists = nullptr;
-int landmark_lists_size = 0;
+std::mutex landmark_mutex;
+std::vector<NormalizedLandmark> landmark_lists;
 
-void LandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
+// Receives both hands of a frame at once; the result is only valid during the call.
+void ResultCallback(const MpLandmarkResult *result, void *user_data) {
     int width = camera_bgr_frame.cols;
     int height = camera_bgr_frame.rows;
-    landmark_lists_size = size;
-    landmark_lists = normalized_landmark_lists;
-    for (int i = 0; i < size; ++i) {
-        auto &landmark = landmark_lists[i];
+    std::lock_guard<std::mutex> lock(landmark_mutex);
+    landmark_lists.assign(result->landmarks_, result->landmarks_ + result->offsets_[result->count_]);
+    for (auto &landmark : landmark_lists) {
         landmark.x_ *= width;
         landmark.y_ *= height;
     }
@@ -28,7 +29,11 @@ void LandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size
 const std::string GRAPH_PATH = "mediapipe/graphs/hand_tracking/hand_tracking_desktop_live.pbtxt";
 
 int main() {
-    CreateHandTrackInterface(GRAPH_PATH.c_str());
+    MpHandle handle = nullptr;
+    if (CreateHandTrackInterface(GRAPH_PATH.c_str(), nullptr, &handle) != MP_OK) {
+        std::cout << GetLastErrorMessage() << std::endl;
+        return -1;
+    }
 
     cv::namedWindow("MediaPipeLibrary");
     cv::VideoCapture capture;
@@ -42,11 +47,11 @@ int main() {
         return -1;
     }
 
-    SetHandTrackObserveCallback(LandmarkCallback);
+    SetHandTrackResultCallback(handle, ResultCallback, nullptr);
 
-    ObserveHandTrack();
+    ObserveHandTrack(handle);
 
-    StartHandTrack();
+    StartHandTrack(handle);
 
     while (grab_frame) {
         capture >> camera_bgr_frame;
@@ -56,13 +61,12 @@ int main() {
         if (camera_bgr_frame.empty()) {
             break;
         }
-        cv::Mat camera_rgb_frame;
-        cv::cvtColor(camera_bgr_frame, camera_rgb_frame, cv::COLOR_BGR2RGB);
-        HandTrackProcess(&camera_rgb_frame);
+        MpImage image{camera_bgr_frame.data, camera_bgr_frame.cols, camera_bgr_frame.rows, static_cast<int>(camera_bgr_frame.step), IMAGE_BGR};
+        HandTrackProcessImage(handle, &image, nullptr, nullptr);
 
         if (camera_bgr_frame.cols > 0) {
-            for (int i = 0; i < landmark_lists_size; ++i) {
-                auto &landmark = landmark_lists[i];
+            std::lock_guard<std::mutex> lock(landmark_mutex);
+            for (const auto &landmark : landmark_lists) {
                 cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, cv::Scalar(255, 0, 0));
             }
             cv::imshow("MediaPipeLibrary", camera_bgr_frame);
@@ -70,7 +74,7 @@ int main() {
         int pressed_key = cv::waitKey(30);
         if (pressed_key >= 0 && pressed_key != 255) grab_frame = false;
     }
-    StopHandTrack();
-    ReleaseHandTrackInterface();
+    StopHandTrack(handle);
+    ReleaseHandTrackInterface(handle);
     return 0;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <thread>
@@ -10,72 +11,32 @@
 
 cv::Mat camera_bgr_frame;
 
-NormalizedLandmark *pose_landmark_lists = nullptr;
-NormalizedLandmark *face_landmark_lists = nullptr;
-NormalizedLandmark *left_hand_landmark_lists = nullptr;
-NormalizedLandmark *right_hand_landmark_lists = nullptr;
+std::mutex landmark_mutex;
+// Indexed by HolisticCallbackType.
+std::vector<NormalizedLandmark> landmark_lists[4];
 
-int pose_landmark_lists_size = 0;
-int face_landmark_lists_size = 0;
-int left_hand_landmark_lists_size = 0;
-int right_hand_landmark_lists_size = 0;
-
-void PoseLandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
-    int width = camera_bgr_frame.cols;
-    int height = camera_bgr_frame.rows;
-    pose_landmark_lists_size = size;
-    pose_landmark_lists = new NormalizedLandmark[size];
-    memcpy(pose_landmark_lists, normalized_landmark_lists, sizeof(NormalizedLandmark) * size);
-    for (int i = 0; i < size; ++i) {
-        auto &landmark = pose_landmark_lists[i];
-        landmark.x_ *= width;
-        landmark.y_ *= height;
-    }
-}
-
-void FaceLandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
-    int width = camera_bgr_frame.cols;
-    int height = camera_bgr_frame.rows;
-    face_landmark_lists_size = size;
-    face_landmark_lists = new NormalizedLandmark[size];
-    memcpy(face_landmark_lists, normalized_landmark_lists, sizeof(NormalizedLandmark) * size);
-    for (int i = 0; i < size; ++i) {
-        auto &landmark = face_landmark_lists[i];
-        landmark.x_ *= width;
-        landmark.y_ *= height;
-    }
-}
-
-void LeftHandLandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
+// Receives pose, face and both hands of one frame together.
+void HolisticResultCallback(const MpHolisticResult *result, void *user_data) {
     int width = camera_bgr_frame.cols;
     int height = camera_bgr_frame.rows;
-    left_hand_landmark_lists_size = size;
-    left_hand_landmark_lists = new NormalizedLandmark[size];
-    memcpy(left_hand_landmark_lists, normalized_landmark_lists, sizeof(NormalizedLandmark) * size);
-    for (int i = 0; i < size; ++i) {
-        auto &landmark = left_hand_landmark_lists[i];
-        landmark.x_ *= width;
-        landmark.y_ *= height;
-    }
-}
-
-void RightHandLandmarkCallback(NormalizedLandmark *normalized_landmark_lists, size_t size) {
-    int width = camera_bgr_frame.cols;
-    int height = camera_bgr_frame.rows;
-    right_hand_landmark_lists_size = size;
-    right_hand_landmark_lists = new NormalizedLandmark[size];
-    memcpy(right_hand_landmark_lists, normalized_landmark_lists, sizeof(NormalizedLandmark) * size);
-    for (int i = 0; i < size; ++i) {
-        auto &landmark = right_hand_landmark_lists[i];
-        landmark.x_ *= width;
-        landmark.y_ *= height;
+    std::lock_guard<std::mutex> lock(landmark_mutex);
+    for (int type = 0; type < 4; ++type) {
+        landmark_lists[type].assign(result->landmarks_[type], result->landmarks_[type] + result->size_[type]);
+        for (auto &landmark : landmark_lists[type]) {
+            landmark.x_ *= width;
+            landmark.y_ *= height;
+        }
     }
 }
 
 const std::string GRAPH_PATH = "mediapipe/graphs/holistic_tracking/holistic_tracking_cpu.pbtxt";
 
 int main() {
-    CreateHolisticTrackInterface(GRAPH_PATH.c_str());
+    MpHandle handle = nullptr;
+    if (CreateHolisticTrackInterface(GRAPH_PATH.c_str(), nullptr, &handle) != MP_OK) {
+        std::cout << GetLastErrorMessage() << std::endl;
+        return -1;
+    }
 
     cv::namedWindow("MediaPipeLibrary");
     cv::VideoCapture capture;
@@ -89,14 +50,11 @@ int main() {
         return -1;
     }
 
-    SetHolisticTrackObserveCallback(PoseLandmarkCallback, HolisticCallbackType::POSE);
-    SetHolisticTrackObserveCallback(FaceLandmarkCallback, HolisticCallbackType::FACE);
-    SetHolisticTrackObserveCallback(LeftHandLandmarkCallback, HolisticCallbackType::LEFT_HAND);
-    SetHolisticTrackObserveCallback(RightHandLandmarkCallback, HolisticCallbackType::RIGHT_HAND);
+    SetHolisticTrackResultCallback(handle, HolisticResultCallback, nullptr);
 
-    ObserveHolisticTrack();
+    ObserveHolisticTrack(handle);
 
-    StartHolisticTrack();
+    StartHolisticTrack(handle);
 
     while (grab_frame) {
         capture >> camera_bgr_frame;
@@ -106,33 +64,23 @@ int main() {
         if (camera_bgr_frame.empty()) {
             break;
         }
-        cv::Mat camera_rgb_frame;
-        cv::cvtColor(camera_bgr_frame, camera_rgb_frame, cv::COLOR_BGR2RGB);
-        HandTrackProcess(&camera_rgb_frame);
+        MpImage image{camera_bgr_frame.data, camera_bgr_frame.cols, camera_bgr_frame.rows, static_cast<int>(camera_bgr_frame.step), IMAGE_BGR};
+        HolisticTrackProcessImage(handle, &image, nullptr, nullptr);
 
         if (camera_bgr_frame.cols > 0) {
-            for (int i = 0; i < pose_landmark_lists_size; ++i) {
-                auto &landmark = pose_landmark_lists[i];
-                cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, cv::Scalar(0, 0, 255));
-            }
-            for (int i = 0; i < face_landmark_lists_size; ++i) {
-                auto &landmark = face_landmark_lists[i];
-                cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, cv::Scalar(255, 0, 0));
-            }
-            for (int i = 0; i < left_hand_landmark_lists_size; ++i) {
-                auto &landmark = left_hand_landmark_lists[i];
-                cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, cv::Scalar(127, 127, 127));
-            }
-            for (int i = 0; i < right_hand_landmark_lists_size; ++i) {
-                auto &landmark = right_hand_landmark_lists[i];
-                cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, cv::Scalar(127, 127, 127));
+            const cv::Scalar colors[] = {cv::Scalar(0, 0, 255), cv::Scalar(255, 0, 0), cv::Scalar(127, 127, 127), cv::Scalar(127, 127, 127)};
+            std::lock_guard<std::mutex> lock(landmark_mutex);
+            for (int type = 0; type < 4; ++type) {
+                for (const auto &landmark : landmark_lists[type]) {
+                    cv::circle(camera_bgr_frame, cv::Point2f(landmark.x_, landmark.y_), 2, colors[type]);
+                }
             }
             cv::imshow("MediaPipeLibrary", camera_bgr_frame);
         }
         int pressed_key = cv::waitKey(30);
         if (pressed_key >= 0 && pressed_key != 255) grab_frame = false;
     }
-    StopHolisticTrack();
-    ReleaseHolisticTrackInterface();
+    StopHolisticTrack(handle);
+    ReleaseHolisticTrackInterface(handle);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,318 @@
+// Runs a landmark graph over many recorded videos and records the results of
+// every frame to one trace per video with RecordTrace, to be read back with
+// OpenTrace.
+//
+//   batch_process --interface pose_track --jobs 8 --output-dir out a.mp4 b.mp4
+//   batch_process --interface hand_track --list videos.txt
+//
+// Each of the --jobs workers takes the next video, decodes it on a separate
+// thread at most --decode-ahead frames ahead, and feeds every frame to its own
+// handle in offline mode, so no frame is dropped. Memory is bounded by the
+// decode queue plus the graph's queues of every worker. Graphs default to one
+// inference thread each, as the workers already occupy the cores.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mediapipe_library.h"
+
+namespace {
+
+// The C API of one interface.
+struct BatchInterface {
+    const char* name_;
+    const char* default_graph_;
+    MpStatus (*create_)(const char* graph_name, const MpOptions* options, MpHandle* handle);
+    MpStatus (*start_)(MpHandle handle);
+    MpStatus (*process_image_at_)(MpHandle handle, const MpImage* image, long long timestamp_us,
+                                  frame_release_callback release, void* user_data);
+    MpStatus (*stop_)(MpHandle handle);
+    MpStatus (*release_)(MpHandle handle);
+};
+
+const BatchInterface kInterfaces[] = {
+    {"face_mesh", "embedded:face_mesh", CreateFaceMeshInterface, StartFaceMesh, FaceMeshProcessImageAt, StopFaceMesh,
+     ReleaseFaceMeshInterface},
+    {"hand_track", "embedded:hand_tracking", CreateHandTrackInterface, StartHandTrack, HandTrackProcessImageAt,
+     StopHandTrack, ReleaseHandTrackInterface},
+    {"pose_track", "embedded:pose_tracking", CreatePoseTrackInterface, StartPoseTrack, PoseTrackProcessImageAt,
+     StopPoseTrack, ReleasePoseTrackInterface},
+    {"holistic_track", "embedded:holistic_tracking", CreateHolisticTrackInterface, StartHolisticTrack,
+     HolisticTrackProcessImageAt, StopHolisticTrack, ReleaseHolisticTrackInterface},
+};
+
+struct BatchArgs {
+    const BatchInterface* interface_{&kInterfaces[0]};
+    std::string graph_;
+    std::string output_dir_{"."};
+    std::vector<std::string> inputs_;
+    int jobs_{0};
+    int decode_ahead_{8};
+    int num_threads_{0};
+    int inference_threads_{1};
+};
+
+struct DecodedFrame {
+    cv::Mat* mat_;
+    long long timestamp_us_;
+};
+
+// Bounded hand-off from a decoder thread to its worker.
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity) : capacity_(capacity) {}
+
+    // Blocks while the queue is full; returns false once it is closed.
+    bool Push(DecodedFrame frame) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return closed_ || frames_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        frames_.push_back(frame);
+        changed_.notify_all();
+        return true;
+    }
+
+    // Returns false once the queue is closed and drained.
+    bool Pop(DecodedFrame* frame) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return closed_ || !frames_.empty(); });
+        if (frames_.empty()) {
+            return false;
+        }
+        *frame = frames_.front();
+        frames_.pop_front();
+        changed_.notify_all();
+        return true;
+    }
+
+    void Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        changed_.notify_all();
+    }
+
+    // Frees the frames nobody will process.
+    ~FrameQueue() {
+        for (auto& frame : frames_) {
+            delete frame.mat_;
+        }
+    }
+
+private:
+    const size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<DecodedFrame> frames_;
+    bool closed_{false};
+};
+
+void ReleaseMat(unsigned char*, void* user_data) {
+    delete static_cast<cv::Mat*>(user_data);
+}
+
+void Decode(const std::string& path, FrameQueue* queue) {
+    cv::VideoCapture capture(path);
+    double fps = capture.isOpened() ? capture.get(cv::CAP_PROP_FPS) : 0.;
+    if (!(fps > 0.)) {
+        fps = 30.;
+    }
+    for (long long index = 0;; ++index) {
+        auto mat = std::make_unique<cv::Mat>();
+        if (!capture.isOpened() || !capture.read(*mat) || mat->empty()) {
+            break;
+        }
+        // Derived from the frame index, so that timestamps increase strictly
+        // even where the container's are missing or repeated.
+        auto timestamp_us = std::llround(index * 1e6 / fps);
+        if (!queue->Push({mat.get(), timestamp_us})) {
+            break;
+        }
+        mat.release();
+    }
+    queue->Close();
+}
+
+std::string OutputPath(const BatchArgs& args, const std::string& input) {
+    auto name = input.substr(input.find_last_of("/\\") + 1);
+    auto dot = name.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) {
+        name.resize(dot);
+    }
+    return args.output_dir_ + "/" + name + ".trace";
+}
+
+// Processes one video; returns false and prints the reason on failure.
+bool ProcessVideo(const BatchArgs& args, const std::string& input) {
+    const auto& interface = *args.interface_;
+    auto output = OutputPath(args, input);
+    MpOptions options{};
+    options.offline_ = 1;
+    options.num_threads_ = args.num_threads_;
+    options.inference_threads_ = args.inference_threads_;
+    MpHandle handle = nullptr;
+    auto graph = args.graph_.empty() ? std::string(interface.default_graph_) : args.graph_;
+    MpStatus status = interface.create_(graph.c_str(), &options, &handle);
+    if (status == MP_OK) {
+        status = RecordTrace(handle, output.c_str());
+    }
+    if (status == MP_OK) {
+        status = interface.start_(handle);
+    }
+    if (status != MP_OK) {
+        std::cerr << input << ": " << GetLastErrorMessage() << std::endl;
+        if (handle) {
+            interface.release_(handle);
+        }
+        return false;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    FrameQueue queue(args.decode_ahead_);
+    std::thread decoder(Decode, input, &queue);
+    DecodedFrame frame{};
+    long long frames = 0;
+    while (queue.Pop(&frame)) {
+        auto* mat = frame.mat_;
+        MpImage image{mat->data, mat->cols, mat->rows, static_cast<int>(mat->step), IMAGE_BGR};
+        // The graph frees the decoded frame once it is done with the pixels.
+        status = interface.process_image_at_(handle, &image, frame.timestamp_us_, ReleaseMat, mat);
+        if (status != MP_OK) {
+            break;
+        }
+        ++frames;
+    }
+    if (status != MP_OK) {
+        std::cerr << input << ": " << GetLastErrorMessage() << std::endl;
+    }
+    queue.Close();
+    decoder.join();
+    // The trace is complete once Stop has recorded every remaining result.
+    auto stop_status = interface.stop_(handle);
+    if (stop_status != MP_OK) {
+        std::cerr << input << ": error writing " << output << ": " << GetLastErrorMessage() << std::endl;
+    }
+    interface.release_(handle);
+    if (status == MP_OK) {
+        status = stop_status;
+    }
+    MpTraceInfo info{};
+    if (status == MP_OK) {
+        MpTraceHandle trace = nullptr;
+        status = OpenTrace(output.c_str(), &trace);
+        if (status == MP_OK) {
+            status = GetTraceInfo(trace, &info);
+            CloseTrace(trace);
+        }
+        if (status != MP_OK) {
+            std::cerr << input << ": cannot read back " << output << ": " << GetLastErrorMessage() << std::endl;
+            return false;
+        }
+    }
+    auto written = info.frame_count_;
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    if (frames == 0 && status == MP_OK) {
+        std::cerr << input << ": no frames decoded" << std::endl;
+        return false;
+    }
+    std::cerr << input << ": " << frames << " frames, " << written << " results, " << seconds << " s, "
+              << (seconds > 0. ? frames / seconds : 0.) << " fps" << std::endl;
+    return status == MP_OK;
+}
+
+void PrintUsage() {
+    std::cerr << "usage: batch_process [--interface face_mesh|hand_track|pose_track|holistic_track]\n"
+              << "       [--graph NAME] [--output-dir DIR] [--jobs N] [--decode-ahead N]\n"
+              << "       [--threads N] [--inference-threads N] [--list FILE] VIDEO..." << std::endl;
+}
+
+bool ParseArgs(int argc, char** argv, BatchArgs* args) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            args->inputs_.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--interface") {
+            auto found = std::find_if(std::begin(kInterfaces), std::end(kInterfaces),
+                                      [&](const BatchInterface& interface) { return value == interface.name_; });
+            if (found == std::end(kInterfaces)) {
+                return false;
+            }
+            args->interface_ = found;
+        } else if (arg == "--graph") {
+            args->graph_ = value;
+        } else if (arg == "--output-dir") {
+            args->output_dir_ = value;
+        } else if (arg == "--jobs") {
+            args->jobs_ = std::atoi(value.c_str());
+        } else if (arg == "--decode-ahead") {
+            args->decode_ahead_ = std::atoi(value.c_str());
+        } else if (arg == "--threads") {
+            args->num_threads_ = std::atoi(value.c_str());
+        } else if (arg == "--inference-threads") {
+            args->inference_threads_ = std::atoi(value.c_str());
+        } else if (arg == "--list") {
+            std::ifstream list(value);
+            if (!list) {
+                return false;
+            }
+            for (std::string line; std::getline(list, line);) {
+                if (!line.empty()) {
+                    args->inputs_.push_back(line);
+                }
+            }
+        } else {
+            return false;
+        }
+    }
+    if (args->jobs_ <= 0) {
+        args->jobs_ = std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+    return !args->inputs_.empty() && args->decode_ahead_ > 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    BatchArgs args;
+    if (!ParseArgs(argc, argv, &args)) {
+        PrintUsage();
+        return 2;
+    }
+    auto jobs = std::min<size_t>(args.jobs_, args.inputs_.size());
+    std::atomic<size_t> next{0};
+    std::atomic<int> failed{0};
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < jobs; ++i) {
+        workers.emplace_back([&] {
+            for (auto index = next++; index < args.inputs_.size(); index = next++) {
+                if (!ProcessVideo(args, args.inputs_[index])) {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::cerr << args.inputs_.size() - failed << " of " << args.inputs_.size() << " videos processed" << std::endl;
+    return failed ? 1 : 0;
+}
@@ -13,11 +13,16 @@
 // limitations under the License.
 
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <utility>
 #include <vector>
 
+#include "absl/time/time.h"
 #include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/clock.h"
+#include "mediapipe/framework/deps/monotonic_clock.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/header_util.h"
 
@@ -27,6 +32,19 @@ constexpr char kFinishedTag[] = "FINISHED";
 constexpr char kAllowTag[] = "ALLOW";
 constexpr char kMaxInFlightTag[] = "MAX_IN_FLIGHT";
 constexpr char kOptionsTag[] = "OPTIONS";
+constexpr char kClockTag[] = "CLOCK";
+constexpr char kDroppedFramesCounter[] = "DroppedFrames";
+constexpr char kInFlightLimitCounter[] = "InFlightLimit";
+constexpr char kInFlightLimitRaisesCounter[] = "InFlightLimitRaises";
+constexpr char kInFlightLimitLowersCounter[] = "InFlightLimitLowers";
+constexpr char kFinishedLatencyCounter[] = "FinishedLatencyUsec";
+
+// The throughput gain below which raising the in-flight limit does not pay
+// off in the adaptive mode.
+constexpr double kMinThroughputGain = 1.05;
+// The number of adjustment windows to wait after a lowered in-flight limit
+// before the adaptive mode tries raising it again.
+constexpr int kWindowsBeforeRaise = 8;
 
 // FlowLimiterCalculator is used to limit the number of frames in flight
 // by dropping input frames when necessary.
@@ -69,6 +87,27 @@ constexpr char kOptionsTag[] = "OPTIONS";
 // input streams are treated as auxiliary input streams.  The auxiliary input
 // streams are limited to timestamps allowed by the "ALLOW" stream.
 //
+// Every dropped frame increments the "<node name>-DroppedFrames" counter of
+// the graph's CounterFactory.
+//
+// With a positive `target_latency_usec`, the number of frames in flight adapts
+// at run time, from `min_in_flight` up to `max_in_flight`. The latency of each
+// frame is measured from its release until its "FINISHED" packet arrives.
+// Every `adjustment_window` finished frames, the limit is lowered by one if
+// the average latency exceeds the target, and raised by one otherwise. A raise
+// that did not increase the throughput by at least 5% over the next window is
+// undone, and after any lowering the next raise waits a few windows. This
+// finds the highest throughput reachable within the latency target without
+// tuning max_in_flight for each machine. The current limit and the average
+// latency of the last window are exported as the "<node name>-InFlightLimit"
+// and "<node name>-FinishedLatencyUsec" counters, and each adjustment
+// increments "<node name>-InFlightLimitRaises" or
+// "<node name>-InFlightLimitLowers".
+//
+// The adaptive mode measures time on the clock in the optional "CLOCK" input
+// side packet, a std::shared_ptr<mediapipe::Clock>, or else on a monotonic
+// clock.
+//
 class FlowLimiterCalculator : public CalculatorBase {
  public:
   static absl::Status GetContract(CalculatorContract* cc) {
@@ -85,6 +124,10 @@ class FlowLimiterCalculator : public CalculatorBase {
     }
     cc->Inputs().Get("FINISHED", 0).SetAny();
     cc->InputSidePackets().Tag(kMaxInFlightTag).Set<int>().Optional();
+    cc->InputSidePackets()
+        .Tag(kClockTag)
+        .Set<std::shared_ptr<::mediapipe::Clock>>()
+        .Optional();
     cc->Outputs().Tag(kAllowTag).Set<bool>().Optional();
     cc->SetInputStreamHandler("ImmediateInputStreamHandler");
     cc->SetProcessTimestampBounds(true);
@@ -98,6 +141,27 @@ class FlowLimiterCalculator : public CalculatorBase {
       options_.set_max_in_flight(
           cc->InputSidePackets().Tag(kMaxInFlightTag).Get<int>());
     }
+    if (options_.target_latency_usec() > 0) {
+      RET_CHECK_GE(options_.min_in_flight(), 1);
+      RET_CHECK_GE(options_.max_in_flight(), options_.min_in_flight());
+      RET_CHECK_GE(options_.adjustment_window(), 1);
+      if (cc->InputSidePackets().HasTag(kClockTag)) {
+        clock_ = cc->InputSidePackets()
+                     .Tag(kClockTag)
+                     .Get<std::shared_ptr<::mediapipe::Clock>>();
+      } else {
+        clock_.reset(
+            ::mediapipe::MonotonicClock::CreateSynchronizedMonotonicClock());
+      }
+      in_flight_limit_ = options_.min_in_flight();
+      raises_counter_ = cc->GetCounter(kInFlightLimitRaisesCounter);
+      lowers_counter_ = cc->GetCounter(kInFlightLimitLowersCounter);
+      limit_counter_ = cc->GetCounter(kInFlightLimitCounter);
+      latency_counter_ = cc->GetCounter(kFinishedLatencyCounter);
+      SetCounter(limit_counter_, in_flight_limit_);
+      SetCounter(latency_counter_, 0);
+    }
+    dropped_frames_counter_ = cc->GetCounter(kDroppedFramesCounter);
     input_queues_.resize(cc->Inputs().NumEntries(""));
     allowed_[Timestamp::Unset()] = true;
     RET_CHECK_OK(CopyInputHeadersToOutputs(cc->Inputs(), &(cc->Outputs())));
@@ -112,7 +176,12 @@ class FlowLimiterCalculator : public CalculatorBase {
     Packet finished_packet = cc->Inputs().Tag(kFinishedTag).Value();
     if (finished_packet.Timestamp() == cc->InputTimestamp()) {
       while (!frames_in_flight_.empty() &&
-             frames_in_flight_.front() <= finished_packet.Timestamp()) {
+             frames_in_flight_.front().timestamp <=
+                 finished_packet.Timestamp()) {
+        if (clock_ != nullptr) {
+          const absl::Time released = frames_in_flight_.front().release_time;
+          RecordFinished(released, clock_->TimeNow() - released);
+        }
         frames_in_flight_.pop_front();
       }
     }
@@ -132,7 +201,13 @@ class FlowLimiterCalculator : public CalculatorBase {
     if (timeout > 0 && latest_ts == cc->InputTimestamp() &&
         latest_ts < Timestamp::Max()) {
       while (!frames_in_flight_.empty() &&
-             (latest_ts - frames_in_flight_.front()) > timeout) {
+             (latest_ts - frames_in_flight_.front().timestamp) > timeout) {
+        // An abandoned frame counts as finished after the timeout, so that
+        // frames overrunning it lower the in-flight limit.
+        if (clock_ != nullptr) {
+          RecordFinished(frames_in_flight_.front().release_time,
+                         absl::Microseconds(timeout.Value()));
+        }
         frames_in_flight_.pop_front();
       }
     }
@@ -144,7 +219,9 @@ class FlowLimiterCalculator : public CalculatorBase {
       input_queue.pop_front();
       cc->Outputs().Get("", 0).AddPacket(packet);
       SendAllow(true, packet.Timestamp(), cc);
-      frames_in_flight_.push_back(packet.Timestamp());
+      frames_in_flight_.push_back(
+          {packet.Timestamp(),
+           clock_ != nullptr ? clock_->TimeNow() : absl::InfinitePast()});
     }
 
     // Limit the number of queued frames.
@@ -154,6 +231,7 @@ class FlowLimiterCalculator : public CalculatorBase {
       Packet packet = input_queue.front();
       input_queue.pop_front();
       SendAllow(false, packet.Timestamp(), cc);
+      dropped_frames_counter_->Increment();
     }
 
     // Propagate the input timestamp bound.
@@ -190,7 +268,70 @@ class FlowLimiterCalculator : public CalculatorBase {
   // Returns true if an additional frame can be released for processing.
   // The "ALLOW" output stream indicates this condition at each input frame.
   bool ProcessingAllowed() {
-    return frames_in_flight_.size() < options_.max_in_flight();
+    const int limit = clock_ != nullptr
+                          ? std::min(in_flight_limit_, options_.max_in_flight())
+                          : options_.max_in_flight();
+    return frames_in_flight_.size() < limit;
+  }
+
+  // Accounts for a frame released at release_time that just finished after
+  // latency, and adjusts the in-flight limit at the end of each adjustment
+  // window.
+  void RecordFinished(absl::Time release_time, absl::Duration latency) {
+    const absl::Time now = clock_->TimeNow();
+    if (window_start_ == absl::InfinitePast()) {
+      window_start_ = release_time;
+    }
+    window_latency_ += latency;
+    if (++window_frames_ < options_.adjustment_window()) {
+      return;
+    }
+    const absl::Duration average_latency = window_latency_ / window_frames_;
+    const double elapsed = absl::ToDoubleSeconds(now - window_start_);
+    const double throughput =
+        elapsed > 0 ? window_frames_ / elapsed : last_throughput_;
+    window_start_ = now;
+    window_latency_ = absl::ZeroDuration();
+    window_frames_ = 0;
+    SetCounter(latency_counter_, absl::ToInt64Microseconds(average_latency));
+
+    const int min_limit = options_.min_in_flight();
+    const int max_limit = options_.max_in_flight();
+    if (average_latency > absl::Microseconds(options_.target_latency_usec()) ||
+        (raised_ && throughput < last_throughput_ * kMinThroughputGain)) {
+      raised_ = false;
+      windows_before_raise_ = kWindowsBeforeRaise;
+      if (in_flight_limit_ > min_limit) {
+        SetInFlightLimit(in_flight_limit_ - 1);
+        lowers_counter_->Increment();
+      }
+    } else if (windows_before_raise_ > 0) {
+      --windows_before_raise_;
+    } else if (in_flight_limit_ < max_limit) {
+      raised_ = true;
+      last_throughput_ = throughput;
+      SetInFlightLimit(in_flight_limit_ + 1);
+      raises_counter_->Increment();
+    } else {
+      raised_ = false;
+    }
+  }
+
+  void SetInFlightLimit(int limit) {
+    in_flight_limit_ = limit;
+    SetCounter(limit_counter_, limit);
+  }
+
+  // Makes a counter report value, in steps that fit Counter::IncrementBy.
+  static void SetCounter(Counter* counter, int64 value) {
+    int64 difference = value - counter->Get();
+    while (difference != 0) {
+      const int step = static_cast<int>(
+          std::clamp<int64>(difference, std::numeric_limits<int>::min(),
+                            std::numeric_limits<int>::max()));
+      counter->IncrementBy(step);
+      difference -= step;
+    }
   }
 
   // Outputs a packet indicating whether a frame was sent or dropped.
@@ -259,8 +400,31 @@ class FlowLimiterCalculator : public CalculatorBase {
  private:
   FlowLimiterCalculatorOptions options_;
   std::vector<std::deque<Packet>> input_queues_;
-  std::deque<Timestamp> frames_in_flight_;
+  // A frame released for processing and not yet finished.
+  struct FrameInFlight {
+    Timestamp timestamp;
+    // Only measured in the adaptive mode.
+    absl::Time release_time;
+  };
+  std::deque<FrameInFlight> frames_in_flight_;
   std::map<Timestamp, bool> allowed_;
+  Counter* dropped_frames_counter_ = nullptr;
+
+  // The state of the adaptive mode. clock_ is null if it is off.
+  std::shared_ptr<::mediapipe::Clock> clock_;
+  int in_flight_limit_ = 0;
+  Counter* limit_counter_ = nullptr;
+  Counter* latency_counter_ = nullptr;
+  Counter* raises_counter_ = nullptr;
+  Counter* lowers_counter_ = nullptr;
+  absl::Time window_start_ = absl::InfinitePast();
+  absl::Duration window_latency_;
+  int window_frames_ = 0;
+  // The throughput in frames per second before the last raise.
+  double last_throughput_ = 0;
+  // True if the limit was raised at the end of the last window.
+  bool raised_ = false;
+  int windows_before_raise_ = 0;
 };
 REGISTER_CALCULATOR(FlowLimiterCalculator);
 
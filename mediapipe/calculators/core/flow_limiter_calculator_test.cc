@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "mediapipe/calculators/core/flow_limiter_calculator.pb.h"
@@ -213,6 +214,16 @@ TEST_F(FlowLimiterCalculatorSemaphoreTest, FramesDropped) {
   // Extra inputs on in_1 have been dropped.
   EXPECT_EQ(TimestampValues(out_1_packets_),
             (std::vector<int64>{0, 10, 20, 30, 40, 50, 60, 70, 80, 90}));
+
+  // Each dropped input has been counted.
+  int64 dropped_frames = 0;
+  for (const auto& counter :
+       graph_.GetCounterFactory()->GetCounterSet()->GetCountersValues()) {
+    if (absl::EndsWith(counter.first, "-DroppedFrames")) {
+      dropped_frames += counter.second;
+    }
+  }
+  EXPECT_EQ(9, dropped_frames);
 }
 
 // A calculator that sleeps during Process.
@@ -980,5 +991,167 @@ TEST_F(FlowLimiterCalculatorTest, AuxiliaryInputs) {
               ElementsAreArray(PacketMatchers<bool>(expected_allow)));
 }
 
+// Tests demonstrating the adaptive mode of FlowLimiterCalculator, which
+// measures the latency of frames through a chain of SleepCalculators in
+// simulated time.
+class FlowLimiterCalculatorAdaptiveTest : public testing::Test {
+ protected:
+  // A graph with stages SleepCalculators between the FlowLimiterCalculator
+  // and its FINISHED input.
+  CalculatorGraphConfig AdaptiveGraphConfig(int stages) {
+    CalculatorGraphConfig config = ParseTextProtoOrDie<CalculatorGraphConfig>(
+        R"pb(
+          input_stream: 'in'
+          node {
+            calculator: 'FlowLimiterCalculator'
+            input_side_packet: 'OPTIONS:limiter_options'
+            input_side_packet: 'CLOCK:limiter_clock'
+            input_stream: 'in'
+            input_stream: 'FINISHED:out'
+            input_stream_info: { tag_index: 'FINISHED' back_edge: true }
+            output_stream: 'stage_0'
+          }
+        )pb");
+    for (int i = 0; i < stages; ++i) {
+      CalculatorGraphConfig::Node* node = config.add_node();
+      node->set_calculator("SleepCalculator");
+      node->add_input_side_packet("WARMUP_TIME:sleep_time");
+      node->add_input_side_packet("SLEEP_TIME:sleep_time");
+      node->add_input_side_packet("CLOCK:clock");
+      node->add_input_stream(absl::StrCat("PACKET:stage_", i));
+      node->add_output_stream(i + 1 < stages
+                                  ? absl::StrCat("PACKET:stage_", i + 1)
+                                  : std::string("PACKET:out"));
+    }
+    return config;
+  }
+
+  // Initialize the test clock to follow simulated time.
+  void SetUpSimulationClock() {
+    auto executor = std::make_shared<SimulationClockExecutor>(8);
+    simulation_clock_ = executor->GetClock();
+    clock_ = simulation_clock_.get();
+    MP_ASSERT_OK(graph_.SetExecutor("", executor));
+  }
+
+  // The side packets for the graph, with both the limiter and the
+  // SleepCalculators on the simulation clock.
+  std::map<std::string, Packet> SidePackets(
+      const FlowLimiterCalculatorOptions& limiter_options, int64 sleep_usec) {
+    return {
+        {"limiter_options",
+         MakePacket<FlowLimiterCalculatorOptions>(limiter_options)},
+        {"sleep_time", MakePacket<int64>(sleep_usec)},
+        {"clock", MakePacket<mediapipe::Clock*>(clock_)},
+        {"limiter_clock", MakePacket<std::shared_ptr<mediapipe::Clock>>(
+                              simulation_clock_)},
+    };
+  }
+
+  // Runs the graph, adding num_packets input packets one period apart, both
+  // in simulated time and in timestamps.
+  void RunGraph(const CalculatorGraphConfig& config,
+                const FlowLimiterCalculatorOptions& limiter_options,
+                int64 sleep_usec, int num_packets, absl::Duration period) {
+    SetUpSimulationClock();
+    MP_ASSERT_OK(graph_.Initialize(config));
+    simulation_clock_->ThreadStart();
+    MP_ASSERT_OK(graph_.StartRun(SidePackets(limiter_options, sleep_usec)));
+    for (int i = 0; i < num_packets; ++i) {
+      MP_EXPECT_OK(graph_.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(
+                    Timestamp(i * absl::ToInt64Microseconds(period)))));
+      clock_->Sleep(period);
+    }
+    MP_EXPECT_OK(graph_.CloseAllInputStreams());
+    clock_->Sleep(absl::Seconds(10));
+    MP_EXPECT_OK(graph_.WaitUntilDone());
+    simulation_clock_->ThreadFinish();
+  }
+
+  // Returns the value of the limiter counter ending with name.
+  int64 CounterValue(const std::string& name) {
+    for (const auto& counter :
+         graph_.GetCounterFactory()->GetCounterSet()->GetCountersValues()) {
+      if (absl::EndsWith(counter.first, absl::StrCat("-", name))) {
+        return counter.second;
+      }
+    }
+    return -1;
+  }
+
+  CalculatorGraph graph_;
+  mediapipe::Clock* clock_;
+  std::shared_ptr<SimulationClock> simulation_clock_;
+};
+
+// Shows that the in-flight limit rises while more frames in flight increase
+// the throughput of a pipeline, and the latency stays within the target.
+TEST_F(FlowLimiterCalculatorAdaptiveTest, RaisesLimitForPipeline) {
+  auto limiter_options = ParseTextProtoOrDie<FlowLimiterCalculatorOptions>(R"pb(
+    max_in_flight: 4
+    max_in_queue: 1
+    target_latency_usec: 1000000
+    adjustment_window: 4
+  )pb");
+  RunGraph(AdaptiveGraphConfig(3), limiter_options, 5000, 300,
+           absl::Milliseconds(1));
+
+  EXPECT_GE(CounterValue("InFlightLimit"), 2);
+  EXPECT_GE(CounterValue("InFlightLimitRaises"), 2);
+  EXPECT_GT(CounterValue("FinishedLatencyUsec"), 0);
+}
+
+// Shows that the in-flight limit falls back when more frames in flight only
+// wait in front of a serial stage, which exceeds the target latency.
+TEST_F(FlowLimiterCalculatorAdaptiveTest, LowersLimitAboveTargetLatency) {
+  auto limiter_options = ParseTextProtoOrDie<FlowLimiterCalculatorOptions>(R"pb(
+    max_in_flight: 4
+    max_in_queue: 1
+    target_latency_usec: 15000
+    adjustment_window: 4
+  )pb");
+  RunGraph(AdaptiveGraphConfig(1), limiter_options, 10000, 100,
+           absl::Milliseconds(2));
+
+  EXPECT_EQ(CounterValue("InFlightLimit"), 1);
+  EXPECT_GE(CounterValue("InFlightLimitRaises"), 1);
+  EXPECT_GE(CounterValue("InFlightLimitLowers"), 1);
+}
+
+// Shows that frames abandoned after in_flight_timeout count as finished with
+// the timeout as their latency.
+TEST_F(FlowLimiterCalculatorAdaptiveTest, CountsTimedOutFrames) {
+  auto limiter_options = ParseTextProtoOrDie<FlowLimiterCalculatorOptions>(R"pb(
+    max_in_flight: 4
+    max_in_queue: 1
+    in_flight_timeout: 30000
+    target_latency_usec: 20000
+    adjustment_window: 4
+  )pb");
+  RunGraph(AdaptiveGraphConfig(1), limiter_options, 100000, 100,
+           absl::Milliseconds(10));
+
+  EXPECT_EQ(CounterValue("FinishedLatencyUsec"), 30000);
+  EXPECT_EQ(CounterValue("InFlightLimit"), 1);
+  EXPECT_EQ(CounterValue("InFlightLimitRaises"), 0);
+}
+
+// Shows that the adaptive mode rejects an empty range of in-flight limits.
+TEST_F(FlowLimiterCalculatorAdaptiveTest, RejectsInvalidLimits) {
+  auto limiter_options = ParseTextProtoOrDie<FlowLimiterCalculatorOptions>(R"pb(
+    max_in_flight: 1
+    min_in_flight: 2
+    target_latency_usec: 10000
+  )pb");
+  SetUpSimulationClock();
+  MP_ASSERT_OK(graph_.Initialize(AdaptiveGraphConfig(1)));
+  simulation_clock_->ThreadStart();
+  MP_ASSERT_OK(graph_.StartRun(SidePackets(limiter_options, 1000)));
+  clock_->Sleep(absl::Milliseconds(10));
+  EXPECT_FALSE(graph_.WaitUntilDone().ok());
+  simulation_clock_->ThreadFinish();
+}
+
 }  // anonymous namespace
 }  // namespace mediapipe
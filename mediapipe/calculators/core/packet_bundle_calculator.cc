@@ -0,0 +1,73 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe {
+
+// Gathers the packets of all input streams at each settled timestamp into a
+// single std::vector<Packet>, one element per input stream in declaration
+// order. An input without a packet at that timestamp contributes an empty
+// packet. Timestamp bound updates are processed too, so a bundle is emitted
+// for every timestamp that any input settles, even when all inputs are empty.
+// This lets a consumer observe one aligned result per frame from several
+// streams that are produced independently and may be absent.
+//
+// Example config:
+// node {
+//   calculator: "PacketBundleCalculator"
+//   input_stream: "landmarks"
+//   input_stream: "handedness"
+//   output_stream: "hand_bundle"
+// }
+class PacketBundleCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    RET_CHECK_GT(cc->Inputs().NumEntries(), 0);
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).SetAny();
+    }
+    cc->Outputs().Index(0).Set<std::vector<Packet>>();
+    cc->SetProcessTimestampBounds(true);
+    return absl::OkStatus();
+  }
+
+  absl::Status Open(CalculatorContext* cc) override {
+    cc->SetOffset(TimestampDiff(0));
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) final {
+    if (!cc->InputTimestamp().IsRangeValue()) {
+      return absl::OkStatus();
+    }
+    auto bundle = absl::make_unique<std::vector<Packet>>();
+    bundle->reserve(cc->Inputs().NumEntries());
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      bundle->push_back(cc->Inputs().Get(id).Value());
+    }
+    cc->Outputs().Index(0).Add(bundle.release(), cc->InputTimestamp());
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(PacketBundleCalculator);
+
+}  // namespace mediapipe
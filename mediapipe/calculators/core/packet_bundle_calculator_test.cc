@@ -0,0 +1,108 @@
+// Copyright 2023 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mediapipe/framework/tool/sink.h"
+
+namespace mediapipe {
+namespace {
+
+class PacketBundleCalculatorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    CalculatorGraphConfig graph_config =
+        ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+          input_stream: 'allow'
+          input_stream: 'a'
+          input_stream: 'b'
+          node {
+            calculator: "GateCalculator"
+            input_stream: 'a'
+            input_stream: 'ALLOW:allow'
+            output_stream: 'gated_a'
+          }
+          node {
+            calculator: 'PacketBundleCalculator'
+            input_stream: 'gated_a'
+            input_stream: 'b'
+            output_stream: 'bundle'
+          }
+        )pb");
+    tool::AddVectorSink("bundle", &graph_config, &output_packets_);
+    MP_ASSERT_OK(graph_.Initialize(graph_config, {}));
+    MP_ASSERT_OK(graph_.StartRun({}));
+  }
+
+  void SendA(int value, bool allow, Timestamp timestamp) {
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        "a", MakePacket<int>(value).At(timestamp)));
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        "allow", MakePacket<bool>(allow).At(timestamp)));
+  }
+
+  void SendB(const std::string& value, Timestamp timestamp) {
+    MP_ASSERT_OK(graph_.AddPacketToInputStream(
+        "b", MakePacket<std::string>(value).At(timestamp)));
+  }
+
+  CalculatorGraph graph_;
+  std::vector<Packet> output_packets_;
+};
+
+TEST_F(PacketBundleCalculatorTest, BundlesAlignedPackets) {
+  SendA(1, true, Timestamp(10));
+  SendB("x", Timestamp(10));
+  MP_ASSERT_OK(graph_.WaitUntilIdle());
+
+  ASSERT_EQ(output_packets_.size(), 1);
+  EXPECT_EQ(output_packets_[0].Timestamp(), Timestamp(10));
+  const auto& bundle = output_packets_[0].Get<std::vector<Packet>>();
+  ASSERT_EQ(bundle.size(), 2);
+  EXPECT_EQ(bundle[0].Get<int>(), 1);
+  EXPECT_EQ(bundle[1].Get<std::string>(), "x");
+
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+}
+
+TEST_F(PacketBundleCalculatorTest, EmitsEmptyPacketsForMissingInputs) {
+  SendA(1, false, Timestamp(10));
+  SendB("x", Timestamp(10));
+  SendA(2, false, Timestamp(11));
+  MP_ASSERT_OK(graph_.CloseAllInputStreams());
+  MP_ASSERT_OK(graph_.WaitUntilDone());
+
+  ASSERT_EQ(output_packets_.size(), 2);
+  const auto& first = output_packets_[0].Get<std::vector<Packet>>();
+  EXPECT_EQ(output_packets_[0].Timestamp(), Timestamp(10));
+  EXPECT_TRUE(first[0].IsEmpty());
+  EXPECT_EQ(first[1].Get<std::string>(), "x");
+  // Neither input carries a packet at 11, yet the timestamp still settles.
+  const auto& second = output_packets_[1].Get<std::vector<Packet>>();
+  EXPECT_EQ(output_packets_[1].Timestamp(), Timestamp(11));
+  EXPECT_TRUE(second[0].IsEmpty());
+  EXPECT_TRUE(second[1].IsEmpty());
+}
+
+}  // namespace
+}  // namespace mediapipe
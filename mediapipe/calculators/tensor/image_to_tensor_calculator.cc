@@ -60,9 +60,11 @@ namespace api2 {
 // normalization, according to specified inputs and options.
 //
 // Inputs:
-//   IMAGE - Image[ImageFormat::SRGB / SRGBA, GpuBufferFormat::kBGRA32] or
-//           ImageFrame [ImageFormat::SRGB/SRGBA] (for backward compatibility
-//           with existing graphs that use IMAGE for ImageFrame input)
+//   IMAGE - Image[ImageFormat::SRGB / SRGBA / SBGR / SBGRA,
+//           GpuBufferFormat::kBGRA32] or
+//           ImageFrame [ImageFormat::SRGB/SRGBA/SBGR/SBGRA] (for backward
+//           compatibility with existing graphs that use IMAGE for ImageFrame
+//           input)
 //   IMAGE_GPU - GpuBuffer [GpuBufferFormat::kBGRA32]
 //     Image to extract from.
 //
@@ -72,6 +74,9 @@ namespace api2 {
 //     GPU (i.e., Image::UsesGpu() returns true), or otherwise processed on CPU.
 //   - IMAGE input of type ImageFrame is always processed on CPU.
 //   - IMAGE_GPU input (of type GpuBuffer) is always processed on GPU.
+//   - SBGR/SBGRA input is only supported on CPU, by the OpenCV converter,
+//     which reorders the channels of the cropped image. The GPU converters
+//     reject it.
 //
 //   NORM_RECT - NormalizedRect @Optional
 //     Describes region of image to extract.
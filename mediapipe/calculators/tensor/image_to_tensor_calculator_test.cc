@@ -267,6 +267,25 @@ TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspect) {
           /*border mode*/ {}, roi);
 }
 
+TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspectBgrInput) {
+  mediapipe::NormalizedRect roi;
+  roi.set_x_center(0.65f);
+  roi.set_y_center(0.4f);
+  roi.set_width(0.5f);
+  roi.set_height(0.5f);
+  roi.set_rotation(0);
+  cv::Mat input;
+  cv::cvtColor(GetRgb(GetFilePath("input.jpg")), input, cv::COLOR_RGB2BGR);
+  ImageFrame input_image(ImageFormat::SBGR, input.cols, input.rows, input.step,
+                         input.data, [](uint8*) {});
+  RunTestWithInputImagePacket(
+      MakePacket<ImageFrame>(std::move(input_image)).At(Timestamp(0)),
+      GetRgb(GetFilePath("medium_sub_rect_keep_aspect.png")),
+      /*range_min=*/0.0f, /*range_max=*/1.0f,
+      /*tensor_width=*/256, /*tensor_height=*/256, /*keep_aspect=*/true,
+      /*border_mode=*/{}, roi, /*output_int_tensor=*/false);
+}
+
 TEST(ImageToTensorCalculatorTest, MediumSubRectKeepAspectBorderZero) {
   mediapipe::NormalizedRect roi;
   roi.set_x_center(0.65f);
@@ -172,6 +172,11 @@ class GlProcessor : public ImageToTensorConverter {
                        float range_min, float range_max,
                        int tensor_buffer_offset,
                        Tensor& output_tensor) override {
+    if (input.image_format() == mediapipe::ImageFormat::SBGR ||
+        input.image_format() == mediapipe::ImageFormat::SBGRA) {
+      return InvalidArgumentError(
+          "BGR(A) images are only supported by the CPU converter.");
+    }
     if (input.format() != mediapipe::GpuBufferFormat::kBGRA32 &&
         input.format() != mediapipe::GpuBufferFormat::kRGBAHalf64 &&
         input.format() != mediapipe::GpuBufferFormat::kRGBAFloat128 &&
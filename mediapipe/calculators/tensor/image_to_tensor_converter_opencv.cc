@@ -68,10 +68,14 @@ class OpenCvProcessor : public ImageToTensorConverter {
                        float range_min, float range_max,
                        int tensor_buffer_offset,
                        Tensor& output_tensor) override {
+    const bool is_bgr_format =
+        input.image_format() == mediapipe::ImageFormat::SBGR ||
+        input.image_format() == mediapipe::ImageFormat::SBGRA;
     const bool is_supported_format =
         input.image_format() == mediapipe::ImageFormat::SRGB ||
         input.image_format() == mediapipe::ImageFormat::SRGBA ||
-        input.image_format() == mediapipe::ImageFormat::GRAY8;
+        input.image_format() == mediapipe::ImageFormat::GRAY8 ||
+        is_bgr_format;
     if (!is_supported_format) {
       return InvalidArgumentError(absl::StrCat(
           "Unsupported format: ", static_cast<uint32_t>(input.image_format())));
@@ -150,7 +154,15 @@ class OpenCvProcessor : public ImageToTensorConverter {
                         /*flags=*/cv::INTER_LINEAR,
                         /*borderMode=*/border_mode_);
 
-    if (transformed.channels() > output_channels) {
+    if (is_bgr_format) {
+      // Reorders channels on the warped ROI only, so BGR(A) frames never need
+      // a full-resolution color conversion.
+      cv::Mat proper_channels_mat;
+      cv::cvtColor(transformed, proper_channels_mat,
+                   transformed.channels() == 4 ? cv::COLOR_BGRA2RGB
+                                               : cv::COLOR_BGR2RGB);
+      transformed = proper_channels_mat;
+    } else if (transformed.channels() > output_channels) {
       cv::Mat proper_channels_mat;
       cv::cvtColor(transformed, proper_channels_mat, cv::COLOR_RGBA2RGB);
       transformed = proper_channels_mat;
@@ -20,6 +20,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/util/tflite/tflite_model_loader.h"
 #include "tensorflow/lite/allocation.h"
 #include "tensorflow/lite/model.h"
 
@@ -36,6 +37,10 @@ namespace mediapipe {
 //                blob and use it as input here.
 //   MODEL_FD   - Tflite model file descriptor std::tuple<int, size_t, size_t>
 //                containing (fd, offset, size).
+//   MODEL_PATH - Path to the TfLite model file (std::string). The model is
+//                loaded through TfLiteModelLoader, which memory-maps it where
+//                possible and shares it with every other graph in the process
+//                that loads the same path.
 //
 // Output side packets:
 //   MODEL - TfLite model. (std::unique_ptr<tflite::FlatBufferModel,
@@ -66,11 +71,30 @@ class TfLiteModelCalculator : public CalculatorBase {
           .Set<std::tuple<int, size_t, size_t>>();
     }
 
+    if (cc->InputSidePackets().HasTag("MODEL_PATH")) {
+      cc->InputSidePackets().Tag("MODEL_PATH").Set<std::string>();
+    }
+
     cc->OutputSidePackets().Tag("MODEL").Set<TfLiteModelPtr>();
     return absl::OkStatus();
   }
 
   absl::Status Open(CalculatorContext* cc) override {
+    if (cc->InputSidePackets().HasTag("MODEL_PATH")) {
+      const auto& model_path =
+          cc->InputSidePackets().Tag("MODEL_PATH").Get<std::string>();
+      ASSIGN_OR_RETURN(auto shared_model,
+                       TfLiteModelLoader::LoadFromPath(model_path));
+      tflite::FlatBufferModel* model = shared_model.Get().get();
+      cc->OutputSidePackets().Tag("MODEL").Set(
+          MakePacket<TfLiteModelPtr>(TfLiteModelPtr(
+              model, [shared_model](tflite::FlatBufferModel*) {
+                // The model belongs to the loader's cache; releasing
+                // shared_model along with this deleter drops the reference.
+              })));
+      return absl::OkStatus();
+    }
+
     Packet model_packet;
     std::unique_ptr<tflite::FlatBufferModel> model;
 
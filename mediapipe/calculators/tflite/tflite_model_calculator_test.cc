@@ -85,4 +85,53 @@ TEST(TfLiteModelCalculatorTest, SmokeTest) {
   }
 }
 
+TEST(TfLiteModelCalculatorTest, SharesModelLoadedFromPath) {
+  CalculatorGraphConfig graph_config = ParseTextProtoOrDie<
+      CalculatorGraphConfig>(
+      R"pb(
+        node {
+          calculator: "ConstantSidePacketCalculator"
+          output_side_packet: "PACKET:model_path"
+          options: {
+            [mediapipe.ConstantSidePacketCalculatorOptions.ext]: {
+              packet {
+                string_value: "mediapipe/calculators/tflite/testdata/add.bin"
+              }
+            }
+          }
+        }
+
+        node {
+          calculator: "TfLiteModelCalculator"
+          input_side_packet: "MODEL_PATH:model_path"
+          output_side_packet: "MODEL:first_model"
+        }
+
+        node {
+          calculator: "TfLiteModelCalculator"
+          input_side_packet: "MODEL_PATH:model_path"
+          output_side_packet: "MODEL:second_model"
+        }
+      )pb");
+  using TfLiteModelPtr =
+      std::unique_ptr<tflite::FlatBufferModel,
+                      std::function<void(tflite::FlatBufferModel*)>>;
+  CalculatorGraph graph(graph_config);
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.WaitUntilIdle());
+  auto first_packet = graph.GetOutputSidePacket("first_model");
+  MP_ASSERT_OK(first_packet);
+  auto second_packet = graph.GetOutputSidePacket("second_model");
+  MP_ASSERT_OK(second_packet);
+  const auto& first_model = first_packet.value().Get<TfLiteModelPtr>();
+  const auto& second_model = second_packet.value().Get<TfLiteModelPtr>();
+
+  ASSERT_NE(first_model, nullptr);
+  EXPECT_EQ(first_model.get(), second_model.get());
+  auto expected_model = tflite::FlatBufferModel::BuildFromFile(
+      "mediapipe/calculators/tflite/testdata/add.bin");
+  EXPECT_EQ(first_model->GetModel()->subgraphs()->size(),
+            expected_model->GetModel()->subgraphs()->size());
+}
+
 }  // namespace mediapipe
@@ -460,6 +460,14 @@ absl::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
         *target_format = ImageFormat::SRGB;
         target_mat_type = CV_8UC3;
         break;
+      case ImageFormat::SBGRA:
+        *target_format = ImageFormat::SRGBA;
+        target_mat_type = CV_8UC4;
+        break;
+      case ImageFormat::SBGR:
+        *target_format = ImageFormat::SRGB;
+        target_mat_type = CV_8UC3;
+        break;
       default:
         return absl::UnknownError("Unexpected image frame format.");
         break;
@@ -473,6 +481,10 @@ absl::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
       cv::Mat rgb_mat;
       cv::cvtColor(input_mat, rgb_mat, CV_GRAY2RGB);
       rgb_mat.copyTo(*image_mat);
+    } else if (input_frame.Format() == ImageFormat::SBGRA) {
+      cv::cvtColor(input_mat, *image_mat, cv::COLOR_BGRA2RGBA);
+    } else if (input_frame.Format() == ImageFormat::SBGR) {
+      cv::cvtColor(input_mat, *image_mat, cv::COLOR_BGR2RGB);
     } else {
       input_mat.copyTo(*image_mat);
     }
@@ -450,18 +450,18 @@ inline Packet<internal::Generic> Packet<internal::Generic>::At(
 
 template <typename T, typename... Args>
 Packet<T> MakePacket(Args&&... args) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(
-      new T(std::forward<Args>(args)...)));
+  return Packet<T>(
+      packet_internal::MakeHolder<T>(std::forward<Args>(args)...));
 }
 
 template <typename T>
 Packet<T> PacketAdopting(const T* ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr));
+  return Packet<T>(packet_internal::AdoptAsHolder(ptr));
 }
 
 template <typename T>
 Packet<T> PacketAdopting(std::unique_ptr<T> ptr) {
-  return Packet<T>(std::make_shared<packet_internal::Holder<T>>(ptr.release()));
+  return Packet<T>(packet_internal::AdoptAsHolder<T>(ptr.release()));
 }
 
 }  // namespace api2
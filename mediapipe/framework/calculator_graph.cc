@@ -17,8 +17,10 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -52,6 +54,7 @@
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/shared_executor.h"
 #include "mediapipe/framework/status_handler.h"
 #include "mediapipe/framework/status_handler.pb.h"
 #include "mediapipe/framework/thread_pool_executor.h"
@@ -74,6 +77,29 @@ namespace {
 // threshold.
 constexpr int kMaxNumAccumulatedErrors = 1000;
 constexpr char kApplicationThreadExecutorType[] = "ApplicationThreadExecutor";
+// Counters of the packet holders created by the calculators, see
+// CalculatorGraphConfig::pool_packet_holders.
+constexpr char kPacketHolderAllocationsCounter[] = "PacketHolderAllocations";
+constexpr char kPooledPacketHolderAllocationsCounter[] =
+    "PooledPacketHolderAllocations";
+// Counters of the work done on the graph's SharedExecutors.
+constexpr char kSharedExecutorCpuTimeCounter[] = "SharedExecutorCpuTimeMicros";
+constexpr char kSharedExecutorTasksCounter[] = "SharedExecutorTasks";
+
+// Increments counter by amount, in steps that fit Counter::IncrementBy.
+void IncrementCounterBy(Counter* counter, int64 amount) {
+  while (amount > 0) {
+    const int step = static_cast<int>(
+        std::min<int64>(amount, std::numeric_limits<int>::max()));
+    counter->IncrementBy(step);
+    amount -= step;
+  }
+}
+
+// Raises counter to value.
+void RaiseCounterTo(Counter* counter, int64 value) {
+  IncrementCounterBy(counter, value - counter->Get());
+}
 
 }  // namespace
 
@@ -236,6 +262,8 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
   // Check if the user has specified a maximum queue size for an input stream.
   max_queue_size_ = validated_graph_->Config().max_queue_size();
   max_queue_size_ = max_queue_size_ ? max_queue_size_ : 100;
+  scheduler_.GetHolderAllocationStats()->use_pool =
+      validated_graph_->Config().pool_packet_holders();
 
   // Use a local variable to avoid needing to lock errors_.
   std::vector<absl::Status> errors;
@@ -271,6 +299,85 @@ absl::Status CalculatorGraph::InitializeCalculatorNodes() {
   return absl::OkStatus();
 }
 
+absl::Status CalculatorGraph::InitializeLatencyBudgets() {
+  const int num_calculators = validated_graph_->CalculatorInfos().size();
+  std::vector<int> priorities(num_calculators, 0);
+  for (const LatencyBudget& budget :
+       validated_graph_->Config().latency_budget()) {
+    const int output_index =
+        validated_graph_->OutputStreamIndex(budget.stream());
+    if (output_index < 0 ||
+        validated_graph_->OutputStreamInfos()[output_index].parent_node.type !=
+            NodeTypeInfo::NodeType::CALCULATOR) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "LatencyBudget for \"" << budget.stream()
+             << "\" does not name the output stream of a node.";
+    }
+    if (budget.budget_usec() < 0) {
+      return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+             << "LatencyBudget for \"" << budget.stream()
+             << "\" has a negative budget_usec.";
+    }
+    int priority = budget.priority();
+    if (priority == 0 && budget.budget_usec() > 0) {
+      priority = 1;
+    }
+
+    // Raises the priority of the nodes the stream depends on, following the
+    // input streams upstream from its producer. Back edges are not followed,
+    // since packets on them arrive too late to matter for the stream.
+    std::vector<bool> visited(num_calculators, false);
+    std::vector<int> pending = {
+        validated_graph_->OutputStreamInfos()[output_index].parent_node.index};
+    visited[pending.back()] = true;
+    while (!pending.empty()) {
+      const int node_id = pending.back();
+      pending.pop_back();
+      priorities[node_id] = std::max(priorities[node_id], priority);
+      const NodeTypeInfo& node_info =
+          validated_graph_->CalculatorInfos()[node_id];
+      for (int i = 0; i < node_info.InputStreamTypes().NumEntries(); ++i) {
+        const EdgeInfo& edge = validated_graph_->InputStreamInfos()
+            [node_info.InputStreamBaseIndex() + i];
+        if (edge.back_edge || edge.upstream < 0) continue;
+        const NodeTypeInfo::NodeRef& upstream_node =
+            validated_graph_->OutputStreamInfos()[edge.upstream].parent_node;
+        if (upstream_node.type == NodeTypeInfo::NodeType::CALCULATOR &&
+            !visited[upstream_node.index]) {
+          visited[upstream_node.index] = true;
+          pending.push_back(upstream_node.index);
+        }
+      }
+    }
+
+    if (budget.budget_usec() > 0) {
+      if (deadline_tracker_ == nullptr) {
+        deadline_tracker_ = absl::make_unique<internal::DeadlineTracker>();
+      }
+      const int index = deadline_tracker_->AddStream(
+          absl::Microseconds(budget.budget_usec()),
+          counter_factory_->GetCounter(
+              absl::StrCat(budget.stream(), "-DeadlinePackets")),
+          counter_factory_->GetCounter(
+              absl::StrCat(budget.stream(), "-DeadlineMisses")));
+      output_stream_managers_[output_index].SetDeadlineTracker(
+          deadline_tracker_.get(), index);
+    }
+  }
+
+  // Nodes of higher priority rank above the others. Within a priority, the
+  // rank keeps the order of the node ids.
+  std::vector<int> order(num_calculators);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&priorities](int a, int b) {
+    return priorities[a] < priorities[b];
+  });
+  for (int rank = 0; rank < num_calculators; ++rank) {
+    nodes_[order[rank]]->SetSchedulingRank(rank);
+  }
+  return absl::OkStatus();
+}
+
 absl::Status CalculatorGraph::InitializePacketGeneratorNodes(
     const std::vector<int>& non_scheduled_generators) {
   // Do not add wrapper nodes again if we are running the graph multiple times.
@@ -417,6 +524,7 @@ absl::Status CalculatorGraph::Initialize(
   MP_RETURN_IF_ERROR(InitializePacketGeneratorGraph(side_packets));
   MP_RETURN_IF_ERROR(InitializeStreams());
   MP_RETURN_IF_ERROR(InitializeCalculatorNodes());
+  MP_RETURN_IF_ERROR(InitializeLatencyBudgets());
 #ifdef MEDIAPIPE_PROFILER_AVAILABLE
   MP_RETURN_IF_ERROR(InitializeProfiler());
 #endif
@@ -668,6 +776,9 @@ absl::Status CalculatorGraph::PrepareForRun(
     has_error_ = false;
   }
   num_closed_graph_input_streams_ = 0;
+  if (deadline_tracker_ != nullptr) {
+    deadline_tracker_->Reset();
+  }
 
   std::map<std::string, Packet> additional_side_packets;
 #if !MEDIAPIPE_DISABLE_GPU
@@ -945,6 +1056,10 @@ absl::Status CalculatorGraph::AddPacketToInputStreamInternal(
                           .set_packet_ts(packet.Timestamp())
                           .set_packet_data_id(&packet));
 
+  if (deadline_tracker_ != nullptr) {
+    deadline_tracker_->RecordArrival(packet.Timestamp());
+  }
+
   // InputStreamManager is thread safe. GraphInputStream is not, so this method
   // should not be called by multiple threads concurrently. Note that this could
   // potentially lead to the max queue size being exceeded by one packet at most
@@ -1348,6 +1463,35 @@ void CalculatorGraph::CleanupAfterRun(absl::Status* status) {
 
   scheduler_.CleanupAfterRun();
 
+  packet_internal::HolderAllocationStats* allocation_stats =
+      scheduler_.GetHolderAllocationStats();
+  if (allocation_stats->use_pool) {
+    IncrementCounterBy(
+        counter_factory_->GetCounter(kPacketHolderAllocationsCounter),
+        allocation_stats->holders.exchange(0));
+    IncrementCounterBy(
+        counter_factory_->GetCounter(kPooledPacketHolderAllocationsCounter),
+        allocation_stats->pooled_holders.exchange(0));
+  }
+
+  // Shared executors keep their totals across runs, as the counters do.
+  int64 shared_executor_cpu_micros = 0;
+  int64 shared_executor_tasks = 0;
+  for (const auto& name_executor : executors_) {
+    if (const SharedExecutor* shared_executor =
+            SharedExecutor::Find(name_executor.second.get())) {
+      shared_executor_cpu_micros +=
+          absl::ToInt64Microseconds(shared_executor->cpu_time());
+      shared_executor_tasks += shared_executor->tasks_run();
+    }
+  }
+  if (shared_executor_tasks > 0) {
+    RaiseCounterTo(counter_factory_->GetCounter(kSharedExecutorCpuTimeCounter),
+                   shared_executor_cpu_micros);
+    RaiseCounterTo(counter_factory_->GetCounter(kSharedExecutorTasksCounter),
+                   shared_executor_tasks);
+  }
+
   {
     absl::MutexLock lock(&error_mutex_);
     errors_.clear();
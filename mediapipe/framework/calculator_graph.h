@@ -35,6 +35,7 @@
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/counter_factory.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/graph_output_stream.h"
 #include "mediapipe/framework/graph_service.h"
@@ -540,6 +541,9 @@ class CalculatorGraph {
   absl::Status InitializeStreams();
   absl::Status InitializeProfiler();
   absl::Status InitializeCalculatorNodes();
+  // Ranks the nodes by the priorities of the latency budgets in the config, and
+  // sets up deadline_tracker_ for the streams with a budget.
+  absl::Status InitializeLatencyBudgets();
   absl::Status InitializePacketGeneratorNodes(
       const std::vector<int>& non_scheduled_generators);
 
@@ -631,6 +635,9 @@ class CalculatorGraph {
   std::vector<std::shared_ptr<internal::GraphOutputStream>>
       graph_output_streams_;
 
+  // Checks the streams with a latency budget. Null if there are none.
+  std::unique_ptr<internal::DeadlineTracker> deadline_tracker_;
+
   // Maximum queue size for an input stream. This is used by the scheduler to
   // restrict memory usage.
   int max_queue_size_ = -1;
@@ -0,0 +1,177 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+// Passes its input through, after appending the node name to the vector in
+// the "ORDER" input side packet, if there is one, and sleeping for the number
+// of milliseconds in the "DELAY_MS" input side packet, if there is one.
+class RecordingCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).SetSameAs(&cc->Inputs().Index(0));
+    if (cc->InputSidePackets().HasTag("ORDER")) {
+      cc->InputSidePackets().Tag("ORDER").Set<std::vector<std::string>*>();
+    }
+    if (cc->InputSidePackets().HasTag("DELAY_MS")) {
+      cc->InputSidePackets().Tag("DELAY_MS").Set<int>();
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Process(CalculatorContext* cc) override {
+    if (cc->InputSidePackets().HasTag("ORDER")) {
+      absl::MutexLock lock(&mutex_);
+      cc->InputSidePackets()
+          .Tag("ORDER")
+          .Get<std::vector<std::string>*>()
+          ->push_back(cc->NodeName());
+    }
+    if (cc->InputSidePackets().HasTag("DELAY_MS")) {
+      absl::SleepFor(absl::Milliseconds(
+          cc->InputSidePackets().Tag("DELAY_MS").Get<int>()));
+    }
+    cc->Outputs().Index(0).AddPacket(cc->Inputs().Index(0).Value());
+    return absl::OkStatus();
+  }
+
+ private:
+  static absl::Mutex mutex_;
+};
+absl::Mutex RecordingCalculator::mutex_;
+REGISTER_CALCULATOR(RecordingCalculator);
+
+// Runs one packet through two nodes fed by the same stream on the application
+// thread, and returns the order in which the nodes ran.
+std::vector<std::string> RunOrder(const std::string& latency_budget) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor { type: 'ApplicationThreadExecutor' }
+        node {
+          name: 'a'
+          calculator: 'RecordingCalculator'
+          input_stream: 'in'
+          output_stream: 'a_out'
+          input_side_packet: 'ORDER:order'
+        }
+        node {
+          name: 'b'
+          calculator: 'RecordingCalculator'
+          input_stream: 'in'
+          output_stream: 'b_out'
+          input_side_packet: 'ORDER:order'
+        }
+      )pb" + latency_budget);
+  std::vector<std::string> order;
+  CalculatorGraph graph;
+  MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+  MEDIAPIPE_CHECK_OK(graph.StartRun(
+      {{"order", MakePacket<std::vector<std::string>*>(&order)}}));
+  MEDIAPIPE_CHECK_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(1).At(Timestamp(0))));
+  MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  return order;
+}
+
+TEST(CalculatorGraphLatencyBudgetTest, LaterNodesRunFirstByDefault) {
+  EXPECT_THAT(RunOrder(""), testing::ElementsAre("b", "a"));
+}
+
+TEST(CalculatorGraphLatencyBudgetTest, PrioritizesNodesFeedingBudgetedStream) {
+  EXPECT_THAT(RunOrder("latency_budget { stream: 'a_out' priority: 1 }"),
+              testing::ElementsAre("a", "b"));
+  // A budget alone also prioritizes the stream.
+  EXPECT_THAT(RunOrder("latency_budget { stream: 'a_out' budget_usec: 1000 }"),
+              testing::ElementsAre("a", "b"));
+  // The stream of higher priority wins.
+  EXPECT_THAT(RunOrder(R"pb(
+                latency_budget { stream: 'a_out' priority: 2 }
+                latency_budget { stream: 'b_out' priority: 1 }
+              )pb"),
+              testing::ElementsAre("a", "b"));
+}
+
+TEST(CalculatorGraphLatencyBudgetTest, CountsDeadlineMisses) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        node {
+          calculator: 'RecordingCalculator'
+          input_stream: 'in'
+          output_stream: 'slow'
+          input_side_packet: 'DELAY_MS:delay_ms'
+        }
+        node {
+          calculator: 'RecordingCalculator'
+          input_stream: 'slow'
+          output_stream: 'out'
+        }
+        latency_budget { stream: 'slow' budget_usec: 5000 }
+        latency_budget { stream: 'out' budget_usec: 10000000 }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  MP_ASSERT_OK(graph.StartRun({{"delay_ms", MakePacket<int>(20)}}));
+  for (int i = 0; i < 3; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+    MP_ASSERT_OK(graph.WaitUntilIdle());
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+
+  CounterFactory* counters = graph.GetCounterFactory();
+  EXPECT_EQ(3, counters->GetCounter("slow-DeadlinePackets")->Get());
+  EXPECT_EQ(3, counters->GetCounter("slow-DeadlineMisses")->Get());
+  EXPECT_EQ(3, counters->GetCounter("out-DeadlinePackets")->Get());
+  EXPECT_EQ(0, counters->GetCounter("out-DeadlineMisses")->Get());
+}
+
+TEST(CalculatorGraphLatencyBudgetTest, RejectsUnknownStream) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        node {
+          calculator: 'RecordingCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+        latency_budget { stream: 'in' budget_usec: 1000 }
+      )pb");
+  CalculatorGraph graph;
+  EXPECT_FALSE(graph.Initialize(config).ok());
+  config.mutable_latency_budget(0)->set_stream("out");
+  config.mutable_latency_budget(0)->set_budget_usec(-1);
+  CalculatorGraph other_graph;
+  EXPECT_FALSE(other_graph.Initialize(config).ok());
+}
+
+}  // namespace
+}  // namespace mediapipe
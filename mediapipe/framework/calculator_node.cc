@@ -151,6 +151,7 @@ absl::Status CalculatorNode::Initialize(
     executor_ = node_config->executor();
   }
   source_layer_ = node_config->source_layer();
+  scheduling_rank_ = node_ref.index;
 
   const CalculatorContract& contract = node_type_info_->Contract();
 
@@ -162,6 +162,11 @@ class CalculatorNode {
 
   int source_layer() const { return source_layer_; }
 
+  // The order in which the scheduler queue runs ready non-source nodes: a
+  // higher rank runs first. Defaults to the node id.
+  int scheduling_rank() const { return scheduling_rank_; }
+  void SetSchedulingRank(int rank) { scheduling_rank_ = rank; }
+
   // Checks if the node can be scheduled; if so, increases current_in_flight_
   // and returns true; otherwise, returns false.
   // If true is returned, the scheduler must commit to executing the node, and
@@ -297,6 +302,7 @@ class CalculatorNode {
   std::string executor_;
   // The layer a source calculator operates on.
   int source_layer_ = 0;
+  int scheduling_rank_ = 0;
   // The status of the current Calculator that this CalculatorNode
   // is wrapping.  kStateActive is currently used only for source nodes.
   enum NodeStatus {
@@ -0,0 +1,101 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/deadline_tracker.h"
+
+#include <algorithm>
+
+#include "absl/time/clock.h"
+
+namespace mediapipe {
+namespace internal {
+
+namespace {
+
+// Arrivals kept for streams that fall behind or skip timestamps. Older ones
+// are dropped, and their packets go unchecked.
+constexpr size_t kMaxArrivals = 1024;
+
+}  // namespace
+
+int DeadlineTracker::AddStream(absl::Duration budget, Counter* packets,
+                               Counter* misses) {
+  absl::MutexLock lock(&mutex_);
+  streams_.push_back({budget, packets, misses});
+  return streams_.size() - 1;
+}
+
+void DeadlineTracker::Reset() {
+  absl::MutexLock lock(&mutex_);
+  arrivals_.clear();
+  for (Stream& stream : streams_) {
+    stream.last = Timestamp::Unstarted();
+  }
+}
+
+void DeadlineTracker::RecordArrival(Timestamp timestamp) {
+  const absl::Time now = absl::Now();
+  absl::MutexLock lock(&mutex_);
+  if (!arrivals_.empty() && arrivals_.back().first >= timestamp) {
+    return;
+  }
+  if (arrivals_.size() == kMaxArrivals) {
+    arrivals_.pop_front();
+  }
+  arrivals_.emplace_back(timestamp, now);
+}
+
+void DeadlineTracker::RecordOutput(int index, Timestamp timestamp) {
+  const absl::Time now = absl::Now();
+  absl::MutexLock lock(&mutex_);
+  Stream& stream = streams_[index];
+  stream.last = std::max(stream.last, timestamp);
+  auto arrival = std::lower_bound(
+      arrivals_.begin(), arrivals_.end(), timestamp,
+      [](const std::pair<Timestamp, absl::Time>& arrival, Timestamp timestamp) {
+        return arrival.first < timestamp;
+      });
+  if (arrival == arrivals_.end() || arrival->first != timestamp) {
+    return;
+  }
+  stream.packets->Increment();
+  if (now - arrival->second > stream.budget) {
+    stream.misses->Increment();
+  }
+  DropPastArrivals();
+}
+
+void DeadlineTracker::RecordBound(int index, Timestamp bound) {
+  absl::MutexLock lock(&mutex_);
+  Stream& stream = streams_[index];
+  const Timestamp last = bound.PreviousAllowedInStream();
+  if (last <= stream.last) {
+    return;
+  }
+  stream.last = last;
+  DropPastArrivals();
+}
+
+void DeadlineTracker::DropPastArrivals() {
+  Timestamp oldest = Timestamp::Done();
+  for (const Stream& stream : streams_) {
+    oldest = std::min(oldest, stream.last);
+  }
+  while (!arrivals_.empty() && arrivals_.front().first <= oldest) {
+    arrivals_.pop_front();
+  }
+}
+
+}  // namespace internal
+}  // namespace mediapipe
@@ -0,0 +1,80 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+#define MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/counter.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+namespace internal {
+
+// Checks the packets of the streams that have a latency budget against the
+// times at which the graph input packets with the same timestamps were added
+// to the graph. Packets whose timestamps no graph input packet had are not
+// checked. Thread-safe.
+class DeadlineTracker {
+ public:
+  // Checks the packets of a stream against budget, and counts them in packets
+  // and those that missed the budget in misses. Returns the index of the
+  // stream for RecordOutput. Must be called before the graph starts.
+  int AddStream(absl::Duration budget, Counter* packets, Counter* misses);
+
+  // Forgets the arrivals of the previous run.
+  void Reset() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that a graph input packet with timestamp is added now. Only the
+  // first packet with each timestamp counts.
+  void RecordArrival(Timestamp timestamp) ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Checks a packet with timestamp output on stream index now.
+  void RecordOutput(int index, Timestamp timestamp)
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Records that stream index outputs no more packets below bound, so that
+  // streams that seldom output packets do not hold on to the arrivals.
+  void RecordBound(int index, Timestamp bound) ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  struct Stream {
+    absl::Duration budget;
+    Counter* packets;
+    Counter* misses;
+    // The timestamp of the last packet checked, or the last timestamp below
+    // the bound of the stream if that is later.
+    Timestamp last = Timestamp::Unstarted();
+  };
+
+  // Drops the arrivals that no stream can still output.
+  void DropPastArrivals() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  absl::Mutex mutex_;
+  // In increasing timestamp order.
+  std::deque<std::pair<Timestamp, absl::Time>> arrivals_
+      ABSL_GUARDED_BY(mutex_);
+  std::vector<Stream> streams_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_DEADLINE_TRACKER_H_
@@ -161,6 +161,11 @@ inline int Image::width() const { return gpu_buffer_.width(); }
 inline int Image::height() const { return gpu_buffer_.height(); }
 
 inline ImageFormat::Format Image::image_format() const {
+  // Some ImageFrame formats, such as SBGR, have no GpuBufferFormat.
+  if (auto storage =
+          gpu_buffer_.internal_storage<GpuBufferStorageImageFrame>()) {
+    return storage->image_frame()->Format();
+  }
   return mediapipe::ImageFormatForGpuBufferFormat(gpu_buffer_.format());
 }
 
@@ -66,6 +66,9 @@ int GetMatType(const mediapipe::ImageFormat::Format format) {
     case mediapipe::ImageFormat::SBGRA:
       type = CV_8U;
       break;
+    case mediapipe::ImageFormat::SBGR:
+      type = CV_8U;
+      break;
     default:
       // Invalid or unknown; Default to uchar.
       type = CV_8U;
@@ -14,6 +14,7 @@
 
 #include "mediapipe/framework/input_stream_manager.h"
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 
@@ -27,6 +28,62 @@
 
 namespace mediapipe {
 
+namespace {
+
+// Capacity of a packet queue before it has held any packets.
+constexpr size_t kMinQueueCapacity = 4;
+// Largest max_queue_size preallocated by SetMaxQueueSize. Larger queues grow
+// only as far as packets actually back up.
+constexpr int kMaxPreallocatedPackets = 1024;
+
+}  // namespace
+
+void InputStreamManager::PacketQueue::push_back(const Packet& packet) {
+  if (size_ == slots_.size()) {
+    Reserve(size_ + 1);
+  }
+  slots_[(head_ + size_) & (slots_.size() - 1)] = packet;
+  ++size_;
+}
+
+void InputStreamManager::PacketQueue::push_back(Packet&& packet) {
+  if (size_ == slots_.size()) {
+    Reserve(size_ + 1);
+  }
+  slots_[(head_ + size_) & (slots_.size() - 1)] = std::move(packet);
+  ++size_;
+}
+
+void InputStreamManager::PacketQueue::pop_front() {
+  // Releases the payload now rather than when the slot is reused.
+  slots_[head_] = Packet();
+  head_ = (head_ + 1) & (slots_.size() - 1);
+  --size_;
+}
+
+void InputStreamManager::PacketQueue::clear() {
+  while (!empty()) {
+    pop_front();
+  }
+  head_ = 0;
+}
+
+void InputStreamManager::PacketQueue::Reserve(size_t n) {
+  if (n <= slots_.size()) {
+    return;
+  }
+  size_t capacity = std::max(slots_.size(), kMinQueueCapacity);
+  while (capacity < n) {
+    capacity *= 2;
+  }
+  std::vector<Packet> slots(capacity);
+  for (size_t i = 0; i < size_; ++i) {
+    slots[i] = std::move(slots_[(head_ + i) & (slots_.size() - 1)]);
+  }
+  slots_.swap(slots);
+  head_ = 0;
+}
+
 absl::Status InputStreamManager::Initialize(const std::string& name,
                                             const PacketType* packet_type,
                                             bool back_edge) {
@@ -49,12 +106,14 @@ void InputStreamManager::SetQueueSizeCallbacks(
 void InputStreamManager::PrepareForRun() {
   absl::MutexLock stream_lock(&stream_mutex_);
   queue_.clear();
+  queue_.Reserve(kMinQueueCapacity);
   last_reported_stream_full_ = false;
   num_packets_added_ = 0;
   next_timestamp_bound_ = Timestamp::PreStream();
   last_select_timestamp_ = Timestamp::Unstarted();
   closed_ = false;
   header_ = Packet();
+  PublishMinTimestampOrBound();
 }
 
 bool InputStreamManager::IsEmpty() const {
@@ -110,6 +169,7 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
     for (auto& packet : container) {
       absl::Status result = packet_type_->Validate(packet);
       if (!result.ok()) {
+        PublishMinTimestampOrBound();
         return tool::AddStatusPrefix(
             absl::StrCat(
                 "Packet type mismatch on a calculator receiving from stream \"",
@@ -119,6 +179,7 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
 
       const Timestamp timestamp = packet.Timestamp();
       if (!timestamp.IsAllowedInStream()) {
+        PublishMinTimestampOrBound();
         return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
                << "In stream \"" << name_
                << "\", timestamp not specified or set to illegal value: "
@@ -130,12 +191,14 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
         // Timestamp::PreStream().NextAllowedInStream() is
         // Timestamp::OneOverPostStream().
         if (timestamp == Timestamp::PostStream() && num_packets_added_ > 0) {
+          PublishMinTimestampOrBound();
           return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
                  << "In stream \"" << name_
                  << "\", a packet at Timestamp::PostStream() must be the only "
                     "Packet in an InputStream.";
         }
         if (timestamp < next_timestamp_bound_) {
+          PublishMinTimestampOrBound();
           return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
                  << "Packet timestamp mismatch on a calculator receiving from "
                     "stream \""
@@ -157,11 +220,12 @@ absl::Status InputStreamManager::AddOrMovePacketsInternal(Container container,
               << " has added packet at time: " << packet.Timestamp();
       if (std::is_const<
               typename std::remove_reference<Container>::type>::value) {
-        queue_.emplace_back(packet);
+        queue_.push_back(packet);
       } else {
-        queue_.emplace_back(std::move(packet));
+        queue_.push_back(std::move(packet));
       }
     }
+    PublishMinTimestampOrBound();
     queue_became_full = (!was_queue_full && max_queue_size_ != -1 &&
                          queue_.size() >= max_queue_size_);
     if (queue_.size() > 1) {
@@ -210,6 +274,7 @@ absl::Status InputStreamManager::SetNextTimestampBound(const Timestamp bound,
         // If the queue was not empty then a change to the next_timestamp_bound_
         // is not detectable by the consumer.
         *notify = true;
+        PublishMinTimestampOrBound();
       }
     }
   }
@@ -226,14 +291,35 @@ void InputStreamManager::Close() {
   next_timestamp_bound_ = Timestamp::Done();
   last_select_timestamp_ = Timestamp::Done();
   closed_ = true;
+  PublishMinTimestampOrBound();
 }
 
 Timestamp InputStreamManager::MinTimestampOrBound(bool* is_empty) const {
-  absl::MutexLock stream_lock(&stream_mutex_);
-  if (is_empty) {
-    *is_empty = queue_.empty();
+  while (true) {
+    const uint32 version = published_version_.load(std::memory_order_acquire);
+    const int64 min_timestamp =
+        published_min_timestamp_.load(std::memory_order_relaxed);
+    const bool empty = published_empty_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Retries if a publish was in progress or happened meanwhile.
+    if ((version & 1) == 0 &&
+        version == published_version_.load(std::memory_order_relaxed)) {
+      if (is_empty) {
+        *is_empty = empty;
+      }
+      return Timestamp::CreateNoErrorChecking(min_timestamp);
+    }
   }
-  return MinTimestampOrBoundHelper();
+}
+
+void InputStreamManager::PublishMinTimestampOrBound() {
+  const uint32 version = published_version_.load(std::memory_order_relaxed);
+  published_version_.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  published_min_timestamp_.store(MinTimestampOrBoundHelper().Value(),
+                                 std::memory_order_relaxed);
+  published_empty_.store(queue_.empty(), std::memory_order_relaxed);
+  published_version_.store(version + 2, std::memory_order_release);
 }
 
 Timestamp InputStreamManager::MinTimestampOrBoundHelper() const
@@ -286,6 +372,7 @@ Packet InputStreamManager::PopPacketAtTimestamp(Timestamp timestamp,
       ++(*num_packets_dropped);
     }
 
+    PublishMinTimestampOrBound();
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
     queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
@@ -318,6 +405,7 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
     } else {
       packet = Packet();
     }
+    PublishMinTimestampOrBound();
 
     VLOG(3) << "Input stream removed a packet:" << name_
             << " Size:" << queue_.size();
@@ -353,6 +441,9 @@ void InputStreamManager::SetMaxQueueSize(int max_queue_size) {
     absl::MutexLock lock(&stream_mutex_);
     was_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
     max_queue_size_ = max_queue_size;
+    if (max_queue_size_ != -1) {
+      queue_.Reserve(std::min(max_queue_size_, kMaxPreallocatedPackets));
+    }
     is_full = (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
   }
 
@@ -376,7 +467,8 @@ Timestamp InputStreamManager::GetMinTimestampAmongNLatest(int n) const {
   if (queue_.empty()) {
     return Timestamp::Unset();
   }
-  return (queue_.cend() - std::min((size_t)n, queue_.size()))->Timestamp();
+  return queue_[queue_.size() - std::min((size_t)n, queue_.size())]
+      .Timestamp();
 }
 
 void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
@@ -390,6 +482,7 @@ void InputStreamManager::ErasePacketsEarlierThan(Timestamp timestamp) {
     while (!queue_.empty() && queue_.front().Timestamp() < timestamp) {
       queue_.pop_front();
     }
+    PublishMinTimestampOrBound();
 
     VLOG(3) << "Input stream removed packets:" << name_
             << " Size:" << queue_.size();
@@ -15,10 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 #define MEDIAPIPE_FRAMEWORK_INPUT_STREAM_MANAGER_H_
 
-#include <deque>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
@@ -111,8 +112,9 @@ class InputStreamManager {
   // this input stream. This is the timestamp of the first item in the queue if
   // the queue is non-empty, or the next timestamp bound if it is empty.
   // Sets is_empty to queue_.empty() if it is not nullptr.
-  Timestamp MinTimestampOrBound(bool* is_empty) const
-      ABSL_LOCKS_EXCLUDED(stream_mutex_);
+  // Does not lock the stream, so that input stream handlers can check the
+  // readiness of a node without contending with the producers.
+  Timestamp MinTimestampOrBound(bool* is_empty) const;
 
   // Turns off the use of packet timestamps.
   void DisableTimestamps();
@@ -156,7 +158,8 @@ class InputStreamManager {
 
   // Sets the maximum queue size for the stream. Used to determine when the
   // callbacks for becomes_full and becomes_not_full should be invoked. A value
-  // of -1 means that there is no maximum queue size.
+  // of -1 means that there is no maximum queue size. The packet queue is
+  // preallocated to hold max_queue_size packets.
   void SetMaxQueueSize(int max_queue_size) ABSL_LOCKS_EXCLUDED(stream_mutex_);
 
   // If there are equal to or more than n packets in the queue, this function
@@ -179,6 +182,33 @@ class InputStreamManager {
                              QueueSizeCallback becomes_not_full_callback);
 
  private:
+  // A FIFO of packets in a ring buffer. The capacity is a power of two that
+  // only grows, so once a stream has seen its largest backlog, adding and
+  // popping packets does not allocate, in this run or the following ones.
+  class PacketQueue {
+   public:
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    Packet& front() { return slots_[head_]; }
+    const Packet& front() const { return slots_[head_]; }
+    // Returns the packet i positions behind the front.
+    const Packet& operator[](size_t i) const {
+      return slots_[(head_ + i) & (slots_.size() - 1)];
+    }
+    void push_back(const Packet& packet);
+    void push_back(Packet&& packet);
+    void pop_front();
+    // Releases the packets and keeps the capacity.
+    void clear();
+    // Grows the capacity to hold at least n packets.
+    void Reserve(size_t n);
+
+   private:
+    std::vector<Packet> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+  };
+
   // Adds or moves a list of timestamped packets. Sets "notify" to true if the
   // queue becomes non-empty. Returns an error if the packets have errors. Does
   // nothing if the input stream is closed.
@@ -195,8 +225,14 @@ class InputStreamManager {
   // Returns the smallest timestamp at which this stream might see an input.
   Timestamp MinTimestampOrBoundHelper() const;
 
+  // Makes the current MinTimestampOrBound() and queue emptiness visible to
+  // MinTimestampOrBound(). Called after every change to queue_ or
+  // next_timestamp_bound_.
+  void PublishMinTimestampOrBound()
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(stream_mutex_);
+
   mutable absl::Mutex stream_mutex_;
-  std::deque<Packet> queue_ ABSL_GUARDED_BY(stream_mutex_);
+  PacketQueue queue_ ABSL_GUARDED_BY(stream_mutex_);
   // The number of packets added to queue_.  Used to verify a packet at
   // Timestamp::PostStream() is the only Packet in the stream.
   int64 num_packets_added_ ABSL_GUARDED_BY(stream_mutex_);
@@ -216,6 +252,13 @@ class InputStreamManager {
   // The maximum queue size for this stream if set.
   int max_queue_size_ ABSL_GUARDED_BY(stream_mutex_) = -1;
 
+  // Sequence lock over the published MinTimestampOrBound() value: odd while
+  // PublishMinTimestampOrBound() is writing, which only happens with
+  // stream_mutex_ held.
+  std::atomic<uint32> published_version_{0};
+  std::atomic<int64> published_min_timestamp_{0};
+  std::atomic<bool> published_empty_{true};
+
   // Callback to notify the framework that we have hit the maximum queue size.
   QueueSizeCallback becomes_full_callback_;
 
@@ -0,0 +1,107 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Packets per second and heap allocations per packet through a chain of
+// PassThroughCalculators, where the input stream queues and the readiness
+// checks of the default input stream handler dominate, e.g.
+//   bazel run -c opt //mediapipe/framework:input_stream_manager_benchmark
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace {
+
+std::atomic<int64_t> num_allocations{0};
+
+}  // namespace
+
+// Counts every heap allocation of the process.
+void* operator new(std::size_t size) {
+  num_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace mediapipe {
+namespace {
+
+constexpr int kNodes = 20;
+// Packets sent through the graph per benchmark iteration.
+constexpr int kPackets = 1000;
+
+CalculatorGraphConfig MakeGraphConfig(int num_threads, int max_queue_size) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("s0");
+  config.set_max_queue_size(max_queue_size);
+  config.add_executor()
+      ->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(num_threads);
+  for (int i = 0; i < kNodes; ++i) {
+    auto* node = config.add_node();
+    node->set_calculator("PassThroughCalculator");
+    node->add_input_stream(absl::StrCat("s", i));
+    node->add_output_stream(absl::StrCat("s", i + 1));
+  }
+  config.add_output_stream(absl::StrCat("s", kNodes));
+  return config;
+}
+
+// Arguments: executor threads, max_queue_size of the graph.
+void BM_PassThroughChain(benchmark::State& state) {
+  CalculatorGraphConfig config = MakeGraphConfig(state.range(0), state.range(1));
+  int64_t allocations = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+    MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+    const int64_t start = num_allocations.load();
+    state.ResumeTiming();
+    for (int i = 0; i < kPackets; ++i) {
+      MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+          "s0", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+    state.PauseTiming();
+    allocations += num_allocations.load() - start;
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * kPackets);
+  state.counters["allocs_per_packet"] = benchmark::Counter(
+      static_cast<double>(allocations) / (state.iterations() * kPackets));
+}
+
+BENCHMARK(BM_PassThroughChain)
+    ->ArgNames({"threads", "max_queue_size"})
+    ->ArgsProduct({{1, 4}, {-1, 100}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -17,6 +17,7 @@
 #include <memory>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/input_stream_shard.h"
 #include "mediapipe/framework/lifetime_tracker.h"
 #include "mediapipe/framework/packet.h"
@@ -924,5 +925,44 @@ TEST_F(InputStreamManagerTest, BackwardsInTimeUntimed) {
   EXPECT_TRUE(notify_);
 }
 
+// The packet queue wraps around and grows while keeping the packet order.
+TEST_F(InputStreamManagerTest, QueueWrapsAroundAndGrows) {
+  int next_added = 0;
+  int next_popped = 0;
+  // Adds more packets than popped each round, so that the backlog grows
+  // across the end of the ring buffer several times.
+  for (int round = 0; round < 20; ++round) {
+    std::list<Packet> packets;
+    for (int i = 0; i < 3; ++i, ++next_added) {
+      packets.push_back(MakePacket<std::string>(absl::StrCat(next_added))
+                            .At(Timestamp(next_added)));
+    }
+    MP_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+    EXPECT_EQ(next_added - next_popped, input_stream_manager_->QueueSize());
+    EXPECT_EQ(Timestamp(next_added - 2),
+              input_stream_manager_->GetMinTimestampAmongNLatest(2));
+    for (int i = 0; i < 2; ++i, ++next_popped) {
+      bool is_empty;
+      EXPECT_EQ(Timestamp(next_popped),
+                input_stream_manager_->MinTimestampOrBound(&is_empty));
+      EXPECT_FALSE(is_empty);
+      popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+          Timestamp(next_popped), &num_packets_dropped_, &stream_is_done_);
+      EXPECT_EQ(0, num_packets_dropped_);
+      EXPECT_EQ(absl::StrCat(next_popped), popped_packet_.Get<std::string>());
+    }
+  }
+  while (next_popped < next_added) {
+    popped_packet_ = input_stream_manager_->PopPacketAtTimestamp(
+        Timestamp(next_popped), &num_packets_dropped_, &stream_is_done_);
+    EXPECT_EQ(absl::StrCat(next_popped), popped_packet_.Get<std::string>());
+    ++next_popped;
+  }
+  bool is_empty;
+  EXPECT_EQ(Timestamp(next_added),
+            input_stream_manager_->MinTimestampOrBound(&is_empty));
+  EXPECT_TRUE(is_empty);
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -178,6 +178,18 @@ void OutputStreamManager::PropagateUpdatesToMirrors(
   VLOG(3) << "Output stream: " << Name()
           << " next timestamp: " << next_timestamp_bound;
   bool add_packets = !packets_to_propagate->empty();
+  if (deadline_tracker_ != nullptr) {
+    if (add_packets) {
+      for (const Packet& packet : *packets_to_propagate) {
+        deadline_tracker_->RecordOutput(deadline_stream_index_,
+                                        packet.Timestamp());
+      }
+    }
+    if (next_timestamp_bound != Timestamp::Unset()) {
+      deadline_tracker_->RecordBound(deadline_stream_index_,
+                                     next_timestamp_bound);
+    }
+  }
   bool set_bound =
       (next_timestamp_bound != Timestamp::Unset()) &&
       (!add_packets ||
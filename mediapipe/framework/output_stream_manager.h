@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deadline_tracker.h"
 #include "mediapipe/framework/output_stream_shard.h"
 #include "mediapipe/framework/packet.h"
 #include "mediapipe/framework/packet_type.h"
@@ -99,6 +100,13 @@ class OutputStreamManager {
 
   void ResetShard(OutputStreamShard* output_stream_shard);
 
+  // Checks the packets propagated from now on as stream index of tracker.
+  // The caller retains the ownership of the tracker.
+  void SetDeadlineTracker(internal::DeadlineTracker* tracker, int index) {
+    deadline_tracker_ = tracker;
+    deadline_stream_index_ = index;
+  }
+
   OutputStreamSpec* Spec() { return &output_stream_spec_; }
 
  private:
@@ -115,6 +123,8 @@ class OutputStreamManager {
   // output stream manager.
   OutputStreamSpec output_stream_spec_;
   std::vector<Mirror> mirrors_;
+  internal::DeadlineTracker* deadline_tracker_ = nullptr;
+  int deadline_stream_index_ = -1;
 
   mutable absl::Mutex stream_mutex_;
   Timestamp next_timestamp_bound_ ABSL_GUARDED_BY(stream_mutex_);
@@ -19,6 +19,7 @@
 
 #include <cstddef>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
 
@@ -28,6 +29,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/no_destructor.h"
 #include "mediapipe/framework/deps/registration.h"
+#include "mediapipe/framework/packet_holder_pool.h"
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -46,6 +48,8 @@ class Packet;
 
 namespace packet_internal {
 class HolderBase;
+template <typename T>
+class Holder;
 
 Packet Create(HolderBase* holder);
 Packet Create(HolderBase* holder, Timestamp timestamp);
@@ -55,6 +59,13 @@ const std::shared_ptr<HolderBase>& GetHolderShared(const Packet& packet);
 std::shared_ptr<HolderBase> GetHolderShared(Packet&& packet);
 absl::StatusOr<Packet> PacketFromDynamicProto(const std::string& type_name,
                                               const std::string& serialized);
+// Returns a holder owning a new T(args...), or taking ownership of ptr.
+// Inside a HolderAllocationScope that uses the pool, the holder is pooled and
+// a small payload is stored in the holder itself.
+template <typename T, typename... Args>
+std::shared_ptr<Holder<T>> MakeHolder(Args&&... args);
+template <typename T>
+std::shared_ptr<Holder<T>> AdoptAsHolder(const T* ptr);
 }  // namespace packet_internal
 
 // A generic container class which can hold data of any type.  The type of
@@ -308,7 +319,9 @@ template <typename T,
           typename std::enable_if<!std::is_array<T>::value>::type* = nullptr,
           typename... Args>
 Packet MakePacket(Args&&... args) {  // NOLINT(build/c++11)
-  return Adopt(new T(std::forward<Args>(args)...));
+  return packet_internal::Create(
+      packet_internal::MakeHolder<T>(std::forward<Args>(args)...),
+      Timestamp::Unset());
 }
 
 // Version for arrays. We have to use reinterpret_cast because new T[N]
@@ -393,6 +406,9 @@ class HolderBase {
   GetVectorOfProtoMessageLite() const = 0;
 
   virtual bool HasForeignOwner() const { return false; }
+
+  // Returns true if the payload is stored in the holder itself.
+  virtual bool HasInlineData() const { return false; }
 };
 
 // Two helper functions to get the proto base pointers.
@@ -519,6 +535,18 @@ class Holder : public HolderBase {
       return InternalError(
           "Foreign holder can't release data ptr without ownership.");
     }
+    if (HasInlineData()) {
+      // The payload is freed along with the holder, so it is moved out.
+      if constexpr (std::is_move_constructible<U>::value &&
+                    !std::is_array<U>::value) {
+        std::unique_ptr<T> data_ptr =
+            absl::make_unique<T>(std::move(*const_cast<T*>(ptr_)));
+        ptr_ = nullptr;
+        return std::move(data_ptr);
+      } else {
+        return InternalError("Can't release data stored in the holder.");
+      }
+    }
     // Casts away constness to make the data mutable after the release.
     std::unique_ptr<T> data_ptr(const_cast<T*>(ptr_));
     ptr_ = nullptr;
@@ -594,6 +622,61 @@ class ForeignHolder : public Holder<T> {
   bool HasForeignOwner() const final { return true; }
 };
 
+// Like Holder, but stores the data in the holder, so that a pooled holder
+// needs no further allocation.
+template <typename T>
+class InlineHolder : public Holder<T> {
+ public:
+  template <typename... Args>
+  explicit InlineHolder(Args&&... args) : Holder<T>(nullptr) {
+    this->ptr_ = new (&storage_) T(std::forward<Args>(args)...);
+  }
+  ~InlineHolder() override {
+    reinterpret_cast<T*>(&storage_)->~T();
+    // Null out ptr_ so it doesn't get deleted by ~Holder.
+    this->ptr_ = nullptr;
+  }
+  bool HasInlineData() const final { return true; }
+
+ private:
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+};
+
+// Payloads stored in pooled holders: small enough for the holder and its
+// reference count to fit a pool block, and movable out for Consume().
+template <typename T>
+constexpr bool kStoreInPooledHolder =
+    !std::is_array<T>::value && std::is_move_constructible<T>::value &&
+    sizeof(T) <= kMaxPooledHolderSize / 2 && alignof(T) <= kHolderPoolAlignment;
+
+template <typename T, typename... Args>
+std::shared_ptr<Holder<T>> MakeHolder(Args&&... args) {
+  HolderAllocationStats* stats = CurrentHolderAllocationStats();
+  if constexpr (kStoreInPooledHolder<T>) {
+    if (stats != nullptr && stats->use_pool) {
+      stats->holders.fetch_add(1, std::memory_order_relaxed);
+      return std::allocate_shared<InlineHolder<T>>(
+          HolderPoolAllocator<InlineHolder<T>>(stats),
+          std::forward<Args>(args)...);
+    }
+  }
+  return AdoptAsHolder<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T>
+std::shared_ptr<Holder<T>> AdoptAsHolder(const T* ptr) {
+  HolderAllocationStats* stats = CurrentHolderAllocationStats();
+  if (stats == nullptr) {
+    return std::make_shared<Holder<T>>(ptr);
+  }
+  stats->holders.fetch_add(1, std::memory_order_relaxed);
+  if (!stats->use_pool) {
+    return std::make_shared<Holder<T>>(ptr);
+  }
+  return std::allocate_shared<Holder<T>>(HolderPoolAllocator<Holder<T>>(stats),
+                                         ptr);
+}
+
 template <typename T>
 Holder<T>* HolderBase::As() {
   if (PayloadIsOfType<T>()) {
@@ -763,7 +846,8 @@ inline Timestamp Packet::Timestamp() const { return timestamp_; }
 template <typename T>
 Packet Adopt(const T* ptr) {
   CHECK(ptr != nullptr);
-  return packet_internal::Create(new packet_internal::Holder<T>(ptr));
+  return packet_internal::Create(packet_internal::AdoptAsHolder(ptr),
+                                 Timestamp::Unset());
 }
 
 template <typename T>
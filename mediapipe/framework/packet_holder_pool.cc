@@ -0,0 +1,194 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_holder_pool.h"
+
+#include <new>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/port/logging.h"
+
+namespace mediapipe {
+namespace packet_internal {
+
+namespace {
+
+constexpr int kNumSizeClasses = kMaxPooledHolderSize / kHolderPoolAlignment;
+// Blocks a thread keeps per size class before it returns a batch to the
+// shared pool.
+constexpr int kMaxCachedBlocks = 256;
+// Blocks moved at once between a thread cache and the shared pool, and carved
+// at once from a new slab.
+constexpr int kBatchBlocks = 64;
+
+int SizeClass(size_t size) {
+  DCHECK_GT(size, 0);
+  DCHECK_LE(size, kMaxPooledHolderSize);
+  return (size - 1) / kHolderPoolAlignment;
+}
+
+size_t BlockSize(int size_class) {
+  return (size_class + 1) * kHolderPoolAlignment;
+}
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeList {
+  FreeBlock* head = nullptr;
+  int size = 0;
+
+  void Push(void* block) {
+    FreeBlock* free_block = static_cast<FreeBlock*>(block);
+    free_block->next = head;
+    head = free_block;
+    ++size;
+  }
+  void* Pop() {
+    FreeBlock* block = head;
+    head = block->next;
+    --size;
+    return block;
+  }
+  // Moves up to n blocks to other.
+  void MoveTo(FreeList* other, int n) {
+    while (n-- > 0 && head != nullptr) {
+      other->Push(Pop());
+    }
+  }
+};
+
+// Blocks returned by the thread caches, shared by all threads. Slabs are
+// never released: the pool keeps the largest number of blocks that were in
+// use at once.
+class SharedPool {
+ public:
+  // Moves up to kBatchBlocks blocks to list, carving a new slab if the pool
+  // has none.
+  void Refill(int size_class, FreeList* list) {
+    {
+      absl::MutexLock lock(&mutex_);
+      lists_[size_class].MoveTo(list, kBatchBlocks);
+    }
+    if (list->head == nullptr) {
+      const size_t block_size = BlockSize(size_class);
+      char* slab = static_cast<char*>(::operator new(block_size *
+                                                     kBatchBlocks));
+      for (int i = 0; i < kBatchBlocks; ++i) {
+        list->Push(slab + i * block_size);
+      }
+    }
+  }
+
+  // Moves up to n blocks from list into the pool.
+  void Return(int size_class, FreeList* list, int n) {
+    absl::MutexLock lock(&mutex_);
+    list->MoveTo(&lists_[size_class], n);
+  }
+
+ private:
+  absl::Mutex mutex_;
+  FreeList lists_[kNumSizeClasses] ABSL_GUARDED_BY(mutex_);
+};
+
+SharedPool& GetSharedPool() {
+  static NoDestructor<SharedPool> pool;
+  return *pool;
+}
+
+class ThreadCache {
+ public:
+  ~ThreadCache();
+
+  void* Allocate(int size_class) {
+    FreeList& list = lists_[size_class];
+    if (list.head == nullptr) {
+      GetSharedPool().Refill(size_class, &list);
+    }
+    return list.Pop();
+  }
+
+  void Deallocate(void* block, int size_class) {
+    FreeList& list = lists_[size_class];
+    list.Push(block);
+    if (list.size > kMaxCachedBlocks) {
+      GetSharedPool().Return(size_class, &list, kBatchBlocks);
+    }
+  }
+
+ private:
+  FreeList lists_[kNumSizeClasses];
+};
+
+// Set once the cache of this thread is destroyed, after which packets
+// released by thread_local destructors still find a pool.
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+  for (int size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+    FreeList& list = lists_[size_class];
+    GetSharedPool().Return(size_class, &list, list.size);
+  }
+  thread_cache_destroyed = true;
+}
+
+ThreadCache* GetThreadCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  thread_local ThreadCache cache;
+  return &cache;
+}
+
+thread_local HolderAllocationStats* current_stats = nullptr;
+
+}  // namespace
+
+void* AllocateHolderBlock(size_t size) {
+  const int size_class = SizeClass(size);
+  if (ThreadCache* cache = GetThreadCache()) {
+    return cache->Allocate(size_class);
+  }
+  FreeList list;
+  GetSharedPool().Refill(size_class, &list);
+  void* block = list.Pop();
+  GetSharedPool().Return(size_class, &list, list.size);
+  return block;
+}
+
+void DeallocateHolderBlock(void* block, size_t size) {
+  const int size_class = SizeClass(size);
+  if (ThreadCache* cache = GetThreadCache()) {
+    cache->Deallocate(block, size_class);
+    return;
+  }
+  FreeList list;
+  list.Push(block);
+  GetSharedPool().Return(size_class, &list, 1);
+}
+
+HolderAllocationStats* CurrentHolderAllocationStats() { return current_stats; }
+
+HolderAllocationScope::HolderAllocationScope(HolderAllocationStats* stats)
+    : previous_(current_stats) {
+  current_stats = stats;
+}
+
+HolderAllocationScope::~HolderAllocationScope() { current_stats = previous_; }
+
+}  // namespace packet_internal
+}  // namespace mediapipe
@@ -0,0 +1,122 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Pooled memory for packet holders. A graph with pool_packet_holders set
+// allocates the holders of the packets its calculators create from per-thread
+// caches of fixed-size blocks, instead of from the heap. The holder, its
+// reference count and, for small payloads, the payload itself then share one
+// pooled block, which returns to the cache of whichever thread releases the
+// last packet.
+
+#ifndef MEDIAPIPE_FRAMEWORK_PACKET_HOLDER_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_PACKET_HOLDER_POOL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+namespace packet_internal {
+
+// Blocks are multiples of kHolderPoolAlignment bytes, up to
+// kMaxPooledHolderSize. Larger allocations go to the heap.
+constexpr size_t kHolderPoolAlignment = 16;
+constexpr size_t kMaxPooledHolderSize = 256;
+
+// Returns a block of at least size bytes, size <= kMaxPooledHolderSize.
+void* AllocateHolderBlock(size_t size);
+// Returns a block from AllocateHolderBlock(size) to the pool. May be called
+// from any thread.
+void DeallocateHolderBlock(void* block, size_t size);
+
+// Counts the packet holders created while the nodes of one graph run.
+struct HolderAllocationStats {
+  // If true, holders are allocated with HolderPoolAllocator.
+  bool use_pool = false;
+  // Holders created.
+  std::atomic<int64> holders{0};
+  // Holders served from the pool rather than the heap.
+  std::atomic<int64> pooled_holders{0};
+};
+
+// Returns the stats of the innermost HolderAllocationScope on this thread, or
+// nullptr outside of any scope.
+HolderAllocationStats* CurrentHolderAllocationStats();
+
+// Attributes the holders created on this thread to stats while in scope.
+class HolderAllocationScope {
+ public:
+  explicit HolderAllocationScope(HolderAllocationStats* stats);
+  ~HolderAllocationScope();
+  HolderAllocationScope(const HolderAllocationScope&) = delete;
+  HolderAllocationScope& operator=(const HolderAllocationScope&) = delete;
+
+ private:
+  HolderAllocationStats* previous_;
+};
+
+// An allocator for std::allocate_shared that takes blocks from the pool and
+// falls back to the heap for objects too large or too aligned for a block.
+template <typename T>
+class HolderPoolAllocator {
+ public:
+  using value_type = T;
+
+  explicit HolderPoolAllocator(HolderAllocationStats* stats) : stats_(stats) {}
+  template <typename U>
+  HolderPoolAllocator(const HolderPoolAllocator<U>& other)  // NOLINT
+      : stats_(other.stats()) {}
+
+  T* allocate(size_t n) {
+    if (!Pooled(n)) {
+      return std::allocator<T>().allocate(n);
+    }
+    stats_->pooled_holders.fetch_add(1, std::memory_order_relaxed);
+    return static_cast<T*>(AllocateHolderBlock(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) {
+    if (!Pooled(n)) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+    DeallocateHolderBlock(p, n * sizeof(T));
+  }
+
+  HolderAllocationStats* stats() const { return stats_; }
+
+  template <typename U>
+  bool operator==(const HolderPoolAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const HolderPoolAllocator<U>&) const {
+    return false;
+  }
+
+ private:
+  static bool Pooled(size_t n) {
+    return n * sizeof(T) <= kMaxPooledHolderSize &&
+           alignof(T) <= kHolderPoolAlignment;
+  }
+
+  // Only used to count allocations; deallocation works without it.
+  HolderAllocationStats* stats_;
+};
+
+}  // namespace packet_internal
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_PACKET_HOLDER_POOL_H_
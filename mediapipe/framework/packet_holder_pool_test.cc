@@ -0,0 +1,200 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/packet_holder_pool.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+using packet_internal::GetHolder;
+using packet_internal::HolderAllocationScope;
+using packet_internal::HolderAllocationStats;
+
+struct LargePayload {
+  char bytes[1024];
+};
+
+TEST(PacketHolderPoolTest, CountsOnlyInsideScope) {
+  EXPECT_EQ(packet_internal::CurrentHolderAllocationStats(), nullptr);
+  Packet outside = MakePacket<int>(1);
+  EXPECT_FALSE(GetHolder(outside)->HasInlineData());
+
+  HolderAllocationStats stats;
+  {
+    HolderAllocationScope scope(&stats);
+    EXPECT_EQ(packet_internal::CurrentHolderAllocationStats(), &stats);
+    Packet inside = MakePacket<int>(2);
+    EXPECT_FALSE(GetHolder(inside)->HasInlineData());
+    EXPECT_EQ(2, inside.Get<int>());
+  }
+  EXPECT_EQ(packet_internal::CurrentHolderAllocationStats(), nullptr);
+  EXPECT_EQ(1, stats.holders.load());
+  EXPECT_EQ(0, stats.pooled_holders.load());
+}
+
+TEST(PacketHolderPoolTest, StoresSmallPayloadInPooledHolder) {
+  HolderAllocationStats stats;
+  stats.use_pool = true;
+  HolderAllocationScope scope(&stats);
+  Packet packet = MakePacket<std::string>("pooled").At(Timestamp(7));
+  EXPECT_TRUE(GetHolder(packet)->HasInlineData());
+  EXPECT_EQ("pooled", packet.Get<std::string>());
+  EXPECT_EQ(Timestamp(7), packet.Timestamp());
+
+  Packet large = MakePacket<LargePayload>();
+  EXPECT_FALSE(GetHolder(large)->HasInlineData());
+  Packet adopted = Adopt(new std::vector<int>(3, 5));
+  EXPECT_FALSE(GetHolder(adopted)->HasInlineData());
+  EXPECT_EQ(3, adopted.Get<std::vector<int>>().size());
+
+  EXPECT_EQ(3, stats.holders.load());
+  EXPECT_EQ(3, stats.pooled_holders.load());
+}
+
+TEST(PacketHolderPoolTest, ConsumeMovesPayloadOutOfPooledHolder) {
+  HolderAllocationStats stats;
+  stats.use_pool = true;
+  HolderAllocationScope scope(&stats);
+  Packet packet = MakePacket<std::string>("consumed");
+  auto consumed = packet.Consume<std::string>();
+  MP_ASSERT_OK(consumed);
+  EXPECT_EQ("consumed", *consumed.value());
+  EXPECT_TRUE(packet.IsEmpty());
+}
+
+TEST(PacketHolderPoolTest, ReleasesPacketsOnAnotherThread) {
+  HolderAllocationStats stats;
+  stats.use_pool = true;
+  for (int round = 0; round < 3; ++round) {
+    std::vector<Packet> packets;
+    {
+      HolderAllocationScope scope(&stats);
+      for (int i = 0; i < 1000; ++i) {
+        packets.push_back(MakePacket<int>(i));
+      }
+    }
+    std::thread consumer([&packets] {
+      for (int i = 0; i < packets.size(); ++i) {
+        EXPECT_EQ(i, packets[i].Get<int>());
+      }
+      packets.clear();
+    });
+    consumer.join();
+  }
+  EXPECT_EQ(3000, stats.pooled_holders.load());
+}
+
+class MakeIntCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(MakeIntCalculator);
+
+TEST(PacketHolderPoolTest, GraphReportsPooledHolders) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        pool_packet_holders: true
+        node {
+          calculator: 'MakeIntCalculator'
+          input_stream: 'in'
+          output_stream: 'mid'
+        }
+        node {
+          calculator: 'MakeIntCalculator'
+          input_stream: 'mid'
+          output_stream: 'out'
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    out_packets.push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 100; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(100, out_packets.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i + 2, out_packets[i].Get<int>());
+    EXPECT_TRUE(GetHolder(out_packets[i])->HasInlineData());
+  }
+  EXPECT_EQ(200, graph.GetCounterFactory()
+                     ->GetCounter("PacketHolderAllocations")
+                     ->Get());
+  EXPECT_EQ(200, graph.GetCounterFactory()
+                     ->GetCounter("PooledPacketHolderAllocations")
+                     ->Get());
+}
+
+TEST(PacketHolderPoolTest, GraphWithoutPoolCountsNothing) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        node {
+          calculator: 'MakeIntCalculator'
+          input_stream: 'in'
+          output_stream: 'out'
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    out_packets.push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  MP_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(1).At(Timestamp(0))));
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(1, out_packets.size());
+  EXPECT_FALSE(GetHolder(out_packets[0])->HasInlineData());
+  auto counters =
+      graph.GetCounterFactory()->GetCounterSet()->GetCountersValues();
+  EXPECT_EQ(0, counters.count("PacketHolderAllocations"));
+  EXPECT_EQ(0, counters.count("PooledPacketHolderAllocations"));
+}
+
+}  // namespace
+}  // namespace mediapipe
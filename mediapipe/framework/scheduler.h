@@ -166,6 +166,11 @@ class Scheduler {
   // Only meant for test purposes. See SchedulerTimer for details.
   internal::SchedulerTimes GetSchedulerTimes();
 
+  // Returns the counts of the packet holders created by the nodes.
+  packet_internal::HolderAllocationStats* GetHolderAllocationStats() {
+    return &shared_.holder_allocation_stats;
+  }
+
  private:
   // State of the scheduler. The figure shows the allowed state transitons.
   //
@@ -14,11 +14,14 @@
 
 #include "mediapipe/framework/scheduler_queue.h"
 
+#include <algorithm>
 #include <memory>
 #include <queue>
 #include <utility>
 
+#include "absl/numeric/bits.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/optional.h"
 #include "mediapipe/framework/calculator_node.h"
 #include "mediapipe/framework/executor.h"
 #include "mediapipe/framework/port/canonical_errors.h"
@@ -40,6 +43,7 @@ SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
   CHECK(cc);
   is_source_ = node->IsSource();
   id_ = node->Id();
+  rank_ = node->scheduling_rank();
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = node->SourceProcessOrder(cc).Value();
@@ -51,6 +55,7 @@ SchedulerQueue::Item::Item(CalculatorNode* node)
   CHECK(node);
   is_source_ = node->IsSource();
   id_ = node->Id();
+  rank_ = node->scheduling_rank();
   if (is_source_) {
     layer_ = node->source_layer();
     source_process_order_ = Timestamp::Unstarted().Value();
@@ -81,11 +86,99 @@ bool SchedulerQueue::Item::operator<(const SchedulerQueue::Item& that) const {
   } else {
     // Non-sources run before sources.
     if (that.is_source_) return false;
-    // For non-sources, higher ids run before lower ids.
-    return id_ < that.id_;
+    // For non-sources, higher ranks run before lower ranks.
+    return rank_ < that.rank_;
   }
 }
 
+void SchedulerQueue::RunQueue::Push(Item item) {
+  if (item.IsOpenNode()) {
+    const int id = item.Id();
+    open_items_.Push(id, std::move(item));
+  } else if (item.IsSource()) {
+    source_items_.push(std::move(item));
+  } else {
+    const int rank = item.Rank();
+    non_source_items_.Push(rank, std::move(item));
+  }
+  ++size_;
+}
+
+SchedulerQueue::Item SchedulerQueue::RunQueue::Pop() {
+  DCHECK_GT(size_, 0);
+  --size_;
+  // OpenNode() runs first, lower ids first. Then non-sources run before
+  // sources, higher ranks first.
+  if (!open_items_.empty()) {
+    return open_items_.PopLowest();
+  }
+  if (!non_source_items_.empty()) {
+    return non_source_items_.PopHighest();
+  }
+  Item item = source_items_.top();
+  source_items_.pop();
+  return item;
+}
+
+void SchedulerQueue::RunQueue::Clear() {
+  open_items_.Clear();
+  non_source_items_.Clear();
+  source_items_ = std::priority_queue<Item>();
+  size_ = 0;
+}
+
+void SchedulerQueue::RunQueue::KeyBuckets::Push(int key, Item item) {
+  DCHECK_GE(key, 0);
+  if (key >= buckets_.size()) {
+    buckets_.resize(key + 1);
+    non_empty_.resize(key / 64 + 1);
+  }
+  buckets_[key].items.push_back(std::move(item));
+  non_empty_[key / 64] |= uint64{1} << (key % 64);
+  ++size_;
+}
+
+SchedulerQueue::Item SchedulerQueue::RunQueue::KeyBuckets::PopLowest() {
+  int word = 0;
+  while (non_empty_[word] == 0) {
+    ++word;
+  }
+  return Take(word * 64 + absl::countr_zero(non_empty_[word]));
+}
+
+SchedulerQueue::Item SchedulerQueue::RunQueue::KeyBuckets::PopHighest() {
+  int word = non_empty_.size() - 1;
+  while (non_empty_[word] == 0) {
+    --word;
+  }
+  return Take(word * 64 + 63 - absl::countl_zero(non_empty_[word]));
+}
+
+SchedulerQueue::Item SchedulerQueue::RunQueue::KeyBuckets::Take(int key) {
+  Bucket& bucket = buckets_[key];
+  Item item = std::move(bucket.items[bucket.head++]);
+  if (bucket.head == bucket.items.size()) {
+    bucket.items.clear();
+    bucket.head = 0;
+    non_empty_[key / 64] &= ~(uint64{1} << (key % 64));
+  } else if (bucket.head >= 16 && bucket.head * 2 >= bucket.items.size()) {
+    bucket.items.erase(bucket.items.begin(),
+                       bucket.items.begin() + bucket.head);
+    bucket.head = 0;
+  }
+  --size_;
+  return item;
+}
+
+void SchedulerQueue::RunQueue::KeyBuckets::Clear() {
+  for (Bucket& bucket : buckets_) {
+    bucket.items.clear();
+    bucket.head = 0;
+  }
+  std::fill(non_empty_.begin(), non_empty_.end(), 0);
+  size_ = 0;
+}
+
 void SchedulerQueue::Reset() {
   absl::MutexLock lock(&mutex_);
   num_pending_tasks_ = 0;
@@ -137,7 +230,7 @@ void SchedulerQueue::AddItemToQueue(Item&& item) {
   {
     absl::MutexLock lock(&mutex_);
     was_idle = IsIdle();
-    queue_.push(item);
+    queue_.Push(std::move(item));
     ++num_tasks_to_add_;
     VLOG(4) << node->DebugName() << " was added to the scheduler queue.";
 
@@ -195,10 +288,10 @@ void SchedulerQueue::RunNextTask() {
     CHECK(!queue_.empty()) << "Called RunNextTask when the queue is empty. "
                               "This should not happen.";
 
-    node = queue_.top().Node();
-    calculator_context = queue_.top().Context();
-    is_open_node = queue_.top().IsOpenNode();
-    queue_.pop();
+    const Item item = queue_.Pop();
+    node = item.Node();
+    calculator_context = item.Context();
+    is_open_node = item.IsOpenNode();
 
     CHECK(!node->Closed())
         << "Scheduled a node that was closed. This should not happen.";
@@ -210,6 +303,11 @@ void SchedulerQueue::RunNextTask() {
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
   AUTORELEASEPOOL {
+    // Holders are only counted, and pooled, if the graph asks for it.
+    absl::optional<packet_internal::HolderAllocationScope> allocation_scope;
+    if (shared_->holder_allocation_stats.use_pool) {
+      allocation_scope.emplace(&shared_->holder_allocation_stats);
+    }
     if (is_open_node) {
       DCHECK(!calculator_context);
       OpenCalculatorNode(node);
@@ -302,9 +400,7 @@ void SchedulerQueue::CleanupAfterRun() {
     CHECK_EQ(num_pending_tasks_, 0);
     CHECK_EQ(num_tasks_to_add_, queue_.size());
     num_tasks_to_add_ = 0;
-    while (!queue_.empty()) {
-      queue_.pop();
-    }
+    queue_.Clear();
   }
   if (!was_idle && idle_callback_) {
     // Became idle.
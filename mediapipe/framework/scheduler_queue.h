@@ -20,6 +20,7 @@
 #include <memory>
 #include <queue>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
 #include "absl/synchronization/mutex.h"
@@ -34,6 +35,9 @@ class CalculatorNode;
 
 namespace internal {
 
+// For testing
+class SchedulerQueueTestPeer;
+
 // Manages a priority queue of nodes to be run on the associated executor.
 class SchedulerQueue : public TaskQueue {
  public:
@@ -53,6 +57,12 @@ class SchedulerQueue : public TaskQueue {
 
     CalculatorContext* Context() const { return cc_; }
 
+    int Id() const { return id_; }
+
+    int Rank() const { return rank_; }
+
+    bool IsSource() const { return is_source_; }
+
     bool IsOpenNode() const { return is_open_node_; }
 
     // This comparison is meant to be used with a std::priority_queue. Since
@@ -62,20 +72,77 @@ class SchedulerQueue : public TaskQueue {
     // - Sources are sorted by layer (lower layer numbers run first), then by
     //   Calculator::SourceProcessOrder (smaller values run first), then by
     //   node id: smaller ids run first, since they come earlier in the config.
-    // - Non-sources are sorted by node id: larger ids run first, because they
-    //   are closer to the leaves.
+    // - Non-sources are sorted by CalculatorNode::scheduling_rank: higher
+    //   ranks run first. The rank is the node id, larger ids being closer to
+    //   the leaves, unless the graph has latency budgets; then the nodes
+    //   feeding the streams of higher priority rank above the others.
     bool operator<(const Item& that) const;
 
    private:
+    friend class SchedulerQueueTestPeer;
+
+    // Used by SchedulerQueueTestPeer to make items without a node.
+    Item() : node_(nullptr), cc_(nullptr) {}
+
     int64 source_process_order_ = 0;
     CalculatorNode* node_;
     CalculatorContext* cc_;
     int id_ = 0;
+    int rank_ = 0;
     int layer_ = 0;
     bool is_source_ = false;
     bool is_open_node_ = false;  // True if the task should run OpenNode().
   };
 
+  // Items waiting to run, taken in the order of Item::operator<. OpenNode()
+  // items are bucketed by node id and non-source items by rank, and a bitmap
+  // of non-empty buckets finds the next one, so neither adding nor taking an
+  // item compares items. Items of the same node are taken in the order they
+  // were added. Sources keep a heap, since their order depends on their
+  // timestamps, but there are few of them.
+  class RunQueue {
+   public:
+    void Push(Item item);
+    // REQUIRES: !empty().
+    Item Pop();
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    void Clear();
+
+   private:
+    class KeyBuckets {
+     public:
+      // REQUIRES: key >= 0.
+      void Push(int key, Item item);
+      bool empty() const { return size_ == 0; }
+      // REQUIRES: !empty().
+      Item PopLowest();
+      Item PopHighest();
+      void Clear();
+
+     private:
+      // The items of one node. Taken items stay allocated until the bucket
+      // drains or its front half has been taken, so that a steady flow of
+      // items does not allocate.
+      struct Bucket {
+        std::vector<Item> items;
+        size_t head = 0;
+      };
+
+      Item Take(int key);
+
+      std::vector<Bucket> buckets_;
+      // Bit key % 64 of word key / 64 is set if buckets_[key] is not empty.
+      std::vector<uint64> non_empty_;
+      size_t size_ = 0;
+    };
+
+    KeyBuckets open_items_;
+    KeyBuckets non_source_items_;
+    std::priority_queue<Item> source_items_;
+    size_t size_ = 0;
+  };
+
   explicit SchedulerQueue(SchedulerShared* shared) : shared_(shared) {}
 
   // Sets the executor that will run the nodes. Must be called before the
@@ -163,7 +230,7 @@ class SchedulerQueue : public TaskQueue {
   int num_tasks_to_add_ ABSL_GUARDED_BY(mutex_);
 
   // Queue of nodes that need to be run.
-  std::priority_queue<Item> queue_ ABSL_GUARDED_BY(mutex_);
+  RunQueue queue_ ABSL_GUARDED_BY(mutex_);
 
   SchedulerShared* const shared_;
 
@@ -0,0 +1,84 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator invocations per second of graphs made of many light
+// calculators, where scheduling dominates, e.g.
+//   bazel run -c opt //mediapipe/framework:scheduler_queue_benchmark
+
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+// Packets sent through the graph per benchmark iteration.
+constexpr int kPackets = 1024;
+
+// Builds width parallel chains of depth PassThroughCalculators each, fed by
+// one input stream, so that many nodes are ready at once.
+CalculatorGraphConfig MakeGraphConfig(int width, int depth, int num_threads) {
+  CalculatorGraphConfig config;
+  config.add_input_stream("in");
+  auto* executor = config.add_executor();
+  executor->mutable_options()
+      ->MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(num_threads);
+  for (int chain = 0; chain < width; ++chain) {
+    std::string input = "in";
+    for (int i = 0; i < depth; ++i) {
+      auto* node = config.add_node();
+      node->set_calculator("PassThroughCalculator");
+      node->add_input_stream(input);
+      input = absl::StrCat("s", chain, "_", i);
+      node->add_output_stream(input);
+    }
+    config.add_output_stream(input);
+  }
+  return config;
+}
+
+// Arguments: chain count, chain depth, executor threads.
+void BM_CalculatorInvocations(benchmark::State& state) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  CalculatorGraphConfig config =
+      MakeGraphConfig(width, depth, state.range(2));
+  for (auto _ : state) {
+    state.PauseTiming();
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+    MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+    state.ResumeTiming();
+    for (int i = 0; i < kPackets; ++i) {
+      MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+    }
+    MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kPackets * width * depth);
+}
+
+BENCHMARK(BM_CalculatorInvocations)
+    ->ArgNames({"chains", "depth", "threads"})
+    ->ArgsProduct({{1, 8}, {4, 32}, {1, 4}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,203 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/scheduler_queue.h"
+
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+namespace internal {
+
+// Makes SchedulerQueue items without calculator nodes. Each item is told
+// apart by its context pointer, which the run queue never dereferences.
+class SchedulerQueueTestPeer {
+ public:
+  using Item = SchedulerQueue::Item;
+
+  explicit SchedulerQueueTestPeer(int max_items) : tags_(max_items) {}
+
+  Item OpenItem(int id) { return MakeItem(id, id, false, true, 0, 0); }
+
+  Item NonSourceItem(int id, int rank) {
+    return MakeItem(id, rank, false, false, 0, 0);
+  }
+
+  Item SourceItem(int id, int layer, int64 source_process_order) {
+    return MakeItem(id, id, true, false, layer, source_process_order);
+  }
+
+ private:
+  Item MakeItem(int id, int rank, bool is_source, bool is_open_node,
+                int layer, int64 source_process_order) {
+    Item item;
+    item.cc_ = reinterpret_cast<CalculatorContext*>(&tags_.at(next_tag_++));
+    item.id_ = id;
+    item.rank_ = rank;
+    item.is_source_ = is_source;
+    item.is_open_node_ = is_open_node;
+    item.layer_ = layer;
+    item.source_process_order_ = source_process_order;
+    return item;
+  }
+
+  std::vector<char> tags_;
+  int next_tag_ = 0;
+};
+
+namespace {
+
+using Item = SchedulerQueue::Item;
+using RunQueue = SchedulerQueue::RunQueue;
+
+// Takes the item that std::priority_queue<Item> would return first, and of
+// several equivalent ones the one added first.
+CalculatorContext* ReferencePop(std::vector<const Item*>* items) {
+  auto next = items->begin();
+  for (auto it = items->begin() + 1; it != items->end(); ++it) {
+    if (**next < **it) next = it;
+  }
+  CalculatorContext* cc = (*next)->Context();
+  items->erase(next);
+  return cc;
+}
+
+// Pushes items in order and checks that the run queue pops all of them in
+// the order of Item::operator<, and items of the same node first in, first
+// out.
+void ExpectPopOrder(std::vector<Item> items) {
+  std::vector<const Item*> reference;
+  for (const Item& item : items) reference.push_back(&item);
+  std::vector<CalculatorContext*> expected;
+  while (!reference.empty()) expected.push_back(ReferencePop(&reference));
+
+  RunQueue queue;
+  for (Item& item : items) queue.Push(std::move(item));
+  EXPECT_EQ(expected.size(), queue.size());
+  std::vector<CalculatorContext*> actual;
+  while (!queue.empty()) actual.push_back(queue.Pop().Context());
+  EXPECT_EQ(expected, actual);
+}
+
+TEST(SchedulerQueueTest, OpenNodeRunsFirstLowerIdsFirst) {
+  SchedulerQueueTestPeer peer(8);
+  std::vector<Item> items;
+  items.push_back(peer.NonSourceItem(5, 5));
+  items.push_back(peer.OpenItem(3));
+  items.push_back(peer.SourceItem(0, 0, 0));
+  items.push_back(peer.OpenItem(1));
+  items.push_back(peer.OpenItem(70));
+  items.push_back(peer.OpenItem(2));
+  ExpectPopOrder(std::move(items));
+}
+
+TEST(SchedulerQueueTest, NonSourcesRunBeforeSourcesHigherRanksFirst) {
+  SchedulerQueueTestPeer peer(8);
+  std::vector<Item> items;
+  items.push_back(peer.SourceItem(9, 0, 0));
+  items.push_back(peer.NonSourceItem(1, 1));
+  items.push_back(peer.NonSourceItem(2, 130));
+  items.push_back(peer.NonSourceItem(3, 4));
+  // A rank that differs from the id decides on its own.
+  items.push_back(peer.NonSourceItem(4, 0));
+  items.push_back(peer.NonSourceItem(0, 64));
+  ExpectPopOrder(std::move(items));
+}
+
+TEST(SchedulerQueueTest, SourcesByLayerThenProcessOrderThenId) {
+  SchedulerQueueTestPeer peer(8);
+  std::vector<Item> items;
+  items.push_back(peer.SourceItem(1, 1, 0));
+  items.push_back(peer.SourceItem(2, 0, 20));
+  items.push_back(peer.SourceItem(3, 0, 10));
+  items.push_back(peer.SourceItem(4, 0, 10));
+  items.push_back(peer.SourceItem(0, 0, 10));
+  items.push_back(peer.SourceItem(5, 2, -5));
+  ExpectPopOrder(std::move(items));
+}
+
+TEST(SchedulerQueueTest, ItemsOfOneNodeFirstInFirstOut) {
+  SchedulerQueueTestPeer peer(16);
+  std::vector<Item> items;
+  for (int i = 0; i < 4; ++i) {
+    items.push_back(peer.NonSourceItem(2, 2));
+    items.push_back(peer.NonSourceItem(1, 1));
+    items.push_back(peer.OpenItem(2));
+    items.push_back(peer.OpenItem(1));
+  }
+  ExpectPopOrder(std::move(items));
+}
+
+// Taking 16 or more items from a bucket compacts it; the remaining and later
+// items keep their order.
+TEST(SchedulerQueueTest, CompactedBucketKeepsOrder) {
+  SchedulerQueueTestPeer peer(100);
+  RunQueue queue;
+  std::vector<CalculatorContext*> pushed;
+  auto push = [&](Item item) {
+    pushed.push_back(item.Context());
+    queue.Push(std::move(item));
+  };
+  for (int i = 0; i < 40; ++i) push(peer.NonSourceItem(3, 3));
+  std::vector<CalculatorContext*> popped;
+  for (int i = 0; i < 20; ++i) popped.push_back(queue.Pop().Context());
+  for (int i = 0; i < 30; ++i) push(peer.NonSourceItem(3, 3));
+  while (!queue.empty()) popped.push_back(queue.Pop().Context());
+  EXPECT_EQ(pushed, popped);
+}
+
+// Interleaves pushes and pops of all kinds of items, so that buckets drain,
+// refill and compact, and checks every pop against Item::operator<.
+TEST(SchedulerQueueTest, MatchesItemOrderWhenInterleaved) {
+  constexpr int kOperations = 5000;
+  SchedulerQueueTestPeer peer(kOperations);
+  std::mt19937 random(42);
+  std::uniform_int_distribution<int> node(0, 99);
+  std::uniform_int_distribution<int> kind(0, 9);
+  RunQueue queue;
+  // Items are kept alive for the reference, and never moved once added.
+  std::vector<Item> items;
+  items.reserve(kOperations);
+  std::vector<const Item*> reference;
+  for (int i = 0; i < kOperations; ++i) {
+    if (!reference.empty() && kind(random) < 4) {
+      ASSERT_EQ(ReferencePop(&reference), queue.Pop().Context());
+      continue;
+    }
+    const int id = node(random);
+    const int k = kind(random);
+    if (k == 0) {
+      items.push_back(peer.OpenItem(id));
+    } else if (k == 1) {
+      // A source node is queued once at a time, so its keys are distinct.
+      items.push_back(peer.SourceItem(id, id % 3, i));
+    } else {
+      items.push_back(peer.NonSourceItem(id, 99 - id));
+    }
+    reference.push_back(&items.back());
+    queue.Push(items.back());
+  }
+  while (!reference.empty()) {
+    ASSERT_EQ(ReferencePop(&reference), queue.Pop().Context());
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace mediapipe
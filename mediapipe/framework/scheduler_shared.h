@@ -25,6 +25,7 @@
 #include "absl/synchronization/mutex.h"
 #include "mediapipe/framework/deps/clock.h"
 #include "mediapipe/framework/deps/monotonic_clock.h"
+#include "mediapipe/framework/packet_holder_pool.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
 
@@ -108,6 +109,8 @@ struct SchedulerShared {
   std::function<void(const absl::Status& error)> error_callback;
   // Collects timing information for measuring overhead.
   internal::SchedulerTimer timer;
+  // Counts the packet holders created by the nodes.
+  packet_internal::HolderAllocationStats holder_allocation_stats;
 };
 
 }  // namespace internal
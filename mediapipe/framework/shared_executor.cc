@@ -0,0 +1,291 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/shared_executor.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/deps/no_destructor.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/shared_executor.pb.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// The pools and executors alive in the process.
+struct Registry {
+  absl::Mutex mutex;
+  absl::flat_hash_map<std::string, std::weak_ptr<SharedWorkerPool>> pools
+      ABSL_GUARDED_BY(mutex);
+  absl::flat_hash_set<const Executor*> executors ABSL_GUARDED_BY(mutex);
+};
+
+Registry& GetRegistry() {
+  static NoDestructor<Registry> registry;
+  return *registry;
+}
+
+// CPU time used by the calling thread so far.
+int64_t ThreadCpuNanos() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+#endif  // CLOCK_THREAD_CPUTIME_ID
+  return absl::GetCurrentTimeNanos();
+}
+
+// Charged in advance for the first task of a client.
+constexpr int64_t kInitialTaskNanos = 10000;
+
+// The pool of the worker running on the current thread.
+thread_local const SharedWorkerPool* current_pool = nullptr;
+
+}  // namespace
+
+thread_local const SharedWorkerPool::Client*
+    SharedWorkerPool::current_client_ = nullptr;
+
+// static
+std::shared_ptr<SharedWorkerPool> SharedWorkerPool::GetOrCreate(
+    const std::string& name, const ThreadOptions& thread_options,
+    int num_threads) {
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  std::weak_ptr<SharedWorkerPool>& entry = registry.pools[name];
+  std::shared_ptr<SharedWorkerPool> pool = entry.lock();
+  if (pool == nullptr) {
+    pool.reset(new SharedWorkerPool(name, thread_options, num_threads));
+    entry = pool;
+  } else if (pool->num_threads() != num_threads) {
+    VLOG(1) << "Shared worker pool \"" << name << "\" keeps its "
+            << pool->num_threads() << " threads instead of " << num_threads
+            << ".";
+  }
+  return pool;
+}
+
+SharedWorkerPool::SharedWorkerPool(const std::string& name,
+                                   const ThreadOptions& thread_options,
+                                   int num_threads)
+    : name_(name),
+      thread_pool_(thread_options,
+                   thread_options.name_prefix().empty()
+                       ? "mediapipe"
+                       : thread_options.name_prefix(),
+                   num_threads) {
+  thread_pool_.StartWorkers();
+  for (int i = 0; i < thread_pool_.num_threads(); ++i) {
+    thread_pool_.Schedule([this] { RunWorker(); });
+  }
+  VLOG(2) << "Started shared worker pool \"" << name_ << "\" with "
+          << thread_pool_.num_threads() << " threads.";
+}
+
+SharedWorkerPool::~SharedWorkerPool() {
+  CHECK(current_pool != this)
+      << "Shared worker pool \"" << name_
+      << "\" is destroyed by one of its own tasks, whose worker would join "
+         "itself.";
+  VLOG(2) << "Terminating shared worker pool \"" << name_ << "\".";
+  {
+    Registry& registry = GetRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    auto it = registry.pools.find(name_);
+    // A new pool may already be registered under the same name.
+    if (it != registry.pools.end() && it->second.expired()) {
+      registry.pools.erase(it);
+    }
+  }
+  absl::MutexLock lock(&mutex_);
+  CHECK(clients_.empty());
+  stopped_ = true;
+  work_available_.SignalAll();
+}
+
+void SharedWorkerPool::AddClient(Client* client) {
+  absl::MutexLock lock(&mutex_);
+  client->virtual_time = virtual_time_;
+  clients_.push_back(client);
+}
+
+void SharedWorkerPool::RemoveClient(Client* client) {
+  CHECK(current_client_ != client)
+      << "A SharedExecutor of pool \"" << name_
+      << "\" is destroyed by one of its own tasks, which would wait for "
+         "itself to finish. Destroy it, or the graph using it, from another "
+         "thread.";
+  absl::MutexLock lock(&mutex_);
+  while (!client->tasks.empty() || client->running > 0) {
+    client_idle_.Wait(&mutex_);
+  }
+  clients_.erase(std::find(clients_.begin(), clients_.end(), client));
+}
+
+void SharedWorkerPool::Schedule(Client* client, std::function<void()> task) {
+  absl::MutexLock lock(&mutex_);
+  if (client->tasks.empty() && client->running == 0) {
+    // An idle client gets no credit for the time it was idle.
+    client->virtual_time = std::max(client->virtual_time, virtual_time_);
+  }
+  client->tasks.push_back(std::move(task));
+  if (client->max_concurrency == 0 ||
+      client->running < client->max_concurrency) {
+    work_available_.Signal();
+  }
+}
+
+SharedWorkerPool::Client* SharedWorkerPool::NextClient() {
+  Client* next = nullptr;
+  for (Client* client : clients_) {
+    if (client->tasks.empty() || (client->max_concurrency > 0 &&
+                                  client->running >= client->max_concurrency)) {
+      continue;
+    }
+    if (next == nullptr || client->virtual_time < next->virtual_time) {
+      next = client;
+    }
+  }
+  return next;
+}
+
+void SharedWorkerPool::RunWorker() {
+  current_pool = this;
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    Client* client = NextClient();
+    if (client == nullptr) {
+      if (stopped_) return;
+      work_available_.Wait(&mutex_);
+      continue;
+    }
+    std::function<void()> task = std::move(client->tasks.front());
+    client->tasks.pop_front();
+    ++client->running;
+    virtual_time_ = std::max(virtual_time_, client->virtual_time);
+    // Charging the expected cost now keeps the other workers from picking
+    // the same client for all of them before this task finishes.
+    const int64_t tasks_run = client->tasks_run.load(std::memory_order_relaxed);
+    const int64_t estimate =
+        tasks_run == 0
+            ? kInitialTaskNanos
+            : client->cpu_nanos.load(std::memory_order_relaxed) / tasks_run;
+    client->virtual_time += static_cast<double>(estimate) / client->weight;
+
+    mutex_.Unlock();
+    const int64_t start = ThreadCpuNanos();
+    current_client_ = client;
+    task();
+    const int64_t used = ThreadCpuNanos() - start;
+    // Releases what the task captured outside of the lock.
+    task = nullptr;
+    current_client_ = nullptr;
+    mutex_.Lock();
+
+    client->virtual_time += static_cast<double>(used - estimate) /
+                            client->weight;
+    client->cpu_nanos.fetch_add(used, std::memory_order_relaxed);
+    client->tasks_run.fetch_add(1, std::memory_order_relaxed);
+    --client->running;
+    if (client->running == 0 && client->tasks.empty()) {
+      client_idle_.SignalAll();
+    }
+  }
+}
+
+// static
+absl::StatusOr<Executor*> SharedExecutor::Create(
+    const MediaPipeOptions& extendable_options) {
+  const SharedExecutorOptions& options =
+      extendable_options.GetExtension(SharedExecutorOptions::ext);
+  if (options.weight() <= 0) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "The weight field in SharedExecutorOptions should be positive "
+              "but is "
+           << options.weight();
+  }
+  if (options.max_concurrency() < 0) {
+    return mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "The max_concurrency field in SharedExecutorOptions should not "
+              "be negative but is "
+           << options.max_concurrency();
+  }
+  MediaPipeOptions thread_pool_options;
+  ThreadPoolExecutorOptions* thread_pool_executor_options =
+      thread_pool_options.MutableExtension(ThreadPoolExecutorOptions::ext);
+  thread_pool_executor_options->CopyFrom(
+      extendable_options.GetExtension(ThreadPoolExecutorOptions::ext));
+  if (!thread_pool_executor_options->has_num_threads()) {
+    thread_pool_executor_options->set_num_threads(NumCPUCores());
+  }
+  ThreadOptions thread_options;
+  int num_threads;
+  MP_RETURN_IF_ERROR(internal::GetThreadPoolOptions(
+      thread_pool_options, &thread_options, &num_threads));
+  return new SharedExecutor(
+      SharedWorkerPool::GetOrCreate(options.pool_name(), thread_options,
+                                    num_threads),
+      options.weight(), options.max_concurrency());
+}
+
+SharedExecutor::SharedExecutor(std::shared_ptr<SharedWorkerPool> pool,
+                               int weight, int max_concurrency)
+    : pool_(std::move(pool)), client_(weight, max_concurrency) {
+  CHECK_GT(weight, 0);
+  pool_->AddClient(&client_);
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  registry.executors.insert(this);
+}
+
+SharedExecutor::~SharedExecutor() {
+  {
+    Registry& registry = GetRegistry();
+    absl::MutexLock lock(&registry.mutex);
+    registry.executors.erase(this);
+  }
+  pool_->RemoveClient(&client_);
+}
+
+void SharedExecutor::Schedule(std::function<void()> task) {
+  pool_->Schedule(&client_, std::move(task));
+}
+
+// static
+const SharedExecutor* SharedExecutor::Find(const Executor* executor) {
+  Registry& registry = GetRegistry();
+  absl::MutexLock lock(&registry.mutex);
+  if (!registry.executors.contains(executor)) {
+    return nullptr;
+  }
+  return static_cast<const SharedExecutor*>(executor);
+}
+
+REGISTER_EXECUTOR(SharedExecutor);
+
+}  // namespace mediapipe
@@ -0,0 +1,159 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+class SharedExecutor;
+
+// A named pool of worker threads shared by the SharedExecutors of any number
+// of graphs in the process. Whenever a worker is free, it runs the oldest
+// task of the executor that received the least CPU time relative to its
+// weight, among the executors with a task waiting and below their
+// max_concurrency. An executor that was idle starts even with the busiest
+// one, rather than with the credit of its idle time.
+//
+// A SharedExecutor waits for its tasks when it is destroyed, and the pool
+// joins its workers, so neither may be destroyed by one of their own tasks:
+// e.g. a graph running on a SharedExecutor must not be destroyed from its
+// output callbacks. Doing so fails a CHECK instead of deadlocking.
+class SharedWorkerPool {
+ public:
+  // Returns the pool registered under name. If no executor holds it, a pool
+  // with num_threads threads is created first.
+  static std::shared_ptr<SharedWorkerPool> GetOrCreate(
+      const std::string& name, const ThreadOptions& thread_options,
+      int num_threads);
+
+  // Must not be called from a worker of the pool.
+  ~SharedWorkerPool();
+
+  const std::string& name() const { return name_; }
+  int num_threads() const { return thread_pool_.num_threads(); }
+
+ private:
+  friend class SharedExecutor;
+
+  // The tasks and CPU time of one SharedExecutor.
+  struct Client {
+    Client(int weight, int max_concurrency)
+        : weight(weight), max_concurrency(max_concurrency) {}
+
+    const int weight;
+    // 0 for no limit.
+    const int max_concurrency;
+    // The following are guarded by the mutex of the pool.
+    std::deque<std::function<void()>> tasks;
+    int running = 0;
+    // CPU nanoseconds charged to the client, divided by its weight. Running
+    // tasks are charged the mean CPU time of the client's tasks in advance.
+    double virtual_time = 0;
+    // Written with the mutex held; read at any time.
+    std::atomic<int64_t> cpu_nanos{0};
+    std::atomic<int64_t> tasks_run{0};
+  };
+
+  SharedWorkerPool(const std::string& name,
+                   const ThreadOptions& thread_options, int num_threads);
+
+  void AddClient(Client* client);
+  // Blocks until the tasks of client have run. Must not be called from a
+  // task of client.
+  void RemoveClient(Client* client);
+  void Schedule(Client* client, std::function<void()> task);
+
+  // Runs tasks until the pool stops.
+  void RunWorker();
+  // Returns the next client to run a task of, or nullptr.
+  Client* NextClient() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const std::string name_;
+
+  absl::Mutex mutex_;
+  absl::CondVar work_available_;
+  absl::CondVar client_idle_;
+  std::vector<Client*> clients_ ABSL_GUARDED_BY(mutex_);
+  // The virtual time of the last client picked, at which clients that were
+  // idle resume.
+  double virtual_time_ ABSL_GUARDED_BY(mutex_) = 0;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+
+  // The client whose task runs on the current thread, if it is a worker.
+  static thread_local const Client* current_client_;
+
+  // Runs one RunWorker loop per thread. Declared last, so that its destructor
+  // joins the threads before the rest of the pool is destroyed.
+  mediapipe::ThreadPool thread_pool_;
+};
+
+// An executor that runs its tasks on a SharedWorkerPool, so that many graphs
+// can share one set of threads, each with a weighted share of them and its
+// own CPU time accounting.
+//
+// Selected with ExecutorConfig type "SharedExecutor", and configured with
+// SharedExecutorOptions. CalculatorGraph reports the CPU time and the tasks of
+// its shared executors in the "SharedExecutorCpuTimeMicros" and
+// "SharedExecutorTasks" counters at the end of each run.
+class SharedExecutor : public Executor {
+ public:
+  static absl::StatusOr<Executor*> Create(
+      const MediaPipeOptions& extendable_options);
+
+  SharedExecutor(std::shared_ptr<SharedWorkerPool> pool, int weight,
+                 int max_concurrency);
+  // Waits for the remaining tasks to run. Must not be called from one of them,
+  // see SharedWorkerPool.
+  ~SharedExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // Returns executor as a SharedExecutor, or nullptr if it is not one.
+  static const SharedExecutor* Find(const Executor* executor);
+
+  SharedWorkerPool* pool() const { return pool_.get(); }
+  int weight() const { return client_.weight; }
+  // CPU time spent in the tasks of this executor. Where threads have no CPU
+  // clock, the wall time of the tasks instead.
+  absl::Duration cpu_time() const {
+    return absl::Nanoseconds(
+        client_.cpu_nanos.load(std::memory_order_relaxed));
+  }
+  int64_t tasks_run() const {
+    return client_.tasks_run.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::shared_ptr<SharedWorkerPool> pool_;
+  SharedWorkerPool::Client client_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
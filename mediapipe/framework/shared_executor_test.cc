@@ -0,0 +1,265 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/shared_executor.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/shared_executor.pb.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+std::unique_ptr<Executor> CreateSharedExecutor(const std::string& pool_name,
+                                               int num_threads, int weight,
+                                               int max_concurrency = 0) {
+  MediaPipeOptions options;
+  SharedExecutorOptions* shared_options =
+      options.MutableExtension(SharedExecutorOptions::ext);
+  shared_options->set_pool_name(pool_name);
+  shared_options->set_weight(weight);
+  shared_options->set_max_concurrency(max_concurrency);
+  options.MutableExtension(ThreadPoolExecutorOptions::ext)
+      ->set_num_threads(num_threads);
+  auto executor = SharedExecutor::Create(options);
+  MEDIAPIPE_CHECK_OK(executor.status());
+  return std::unique_ptr<Executor>(executor.value());
+}
+
+// Spins for the given CPU time, roughly.
+void BusyWait(absl::Duration duration) {
+  const absl::Time end = absl::Now() + duration;
+  while (absl::Now() < end) {
+  }
+}
+
+TEST(SharedExecutorTest, SharesPoolsByName) {
+  auto first = CreateSharedExecutor("shares_pools", 2, 1);
+  auto second = CreateSharedExecutor("shares_pools", 3, 1);
+  auto other = CreateSharedExecutor("shares_pools_other", 1, 1);
+  const SharedExecutor* first_shared = SharedExecutor::Find(first.get());
+  ASSERT_NE(first_shared, nullptr);
+  EXPECT_EQ(first_shared->pool(), SharedExecutor::Find(second.get())->pool());
+  EXPECT_NE(first_shared->pool(), SharedExecutor::Find(other.get())->pool());
+  // The first executor of a pool sizes it.
+  EXPECT_EQ(2, first_shared->pool()->num_threads());
+  EXPECT_EQ("shares_pools", first_shared->pool()->name());
+}
+
+TEST(SharedExecutorTest, FindsOnlySharedExecutors) {
+  MediaPipeOptions options;
+  options.MutableExtension(ThreadPoolExecutorOptions::ext)->set_num_threads(1);
+  auto thread_pool_executor = ExecutorRegistry::CreateByName(
+      "ThreadPoolExecutor", options);
+  MP_ASSERT_OK(thread_pool_executor);
+  std::unique_ptr<Executor> executor(thread_pool_executor.value());
+  EXPECT_EQ(SharedExecutor::Find(executor.get()), nullptr);
+}
+
+TEST(SharedExecutorTest, RejectsInvalidOptions) {
+  MediaPipeOptions options;
+  options.MutableExtension(SharedExecutorOptions::ext)->set_weight(0);
+  EXPECT_FALSE(SharedExecutor::Create(options).ok());
+  options.MutableExtension(SharedExecutorOptions::ext)->set_weight(1);
+  options.MutableExtension(SharedExecutorOptions::ext)->set_max_concurrency(-1);
+  EXPECT_FALSE(SharedExecutor::Create(options).ok());
+}
+
+TEST(SharedExecutorTest, RunsAllTasksBeforeDestruction) {
+  std::atomic<int> count(0);
+  auto other = CreateSharedExecutor("runs_all_tasks", 4, 1);
+  {
+    auto executor = CreateSharedExecutor("runs_all_tasks", 4, 1);
+    for (int i = 0; i < 1000; ++i) {
+      executor->Schedule([&count] { ++count; });
+    }
+  }
+  EXPECT_EQ(1000, count);
+}
+
+TEST(SharedExecutorTest, AccountsCpuTimePerExecutor) {
+  auto busy = CreateSharedExecutor("accounts_cpu_time", 2, 1);
+  auto idle = CreateSharedExecutor("accounts_cpu_time", 2, 1);
+  const SharedExecutor* busy_shared = SharedExecutor::Find(busy.get());
+  const SharedExecutor* idle_shared = SharedExecutor::Find(idle.get());
+  absl::Notification done;
+  std::atomic<int> remaining(10);
+  for (int i = 0; i < 10; ++i) {
+    busy->Schedule([&] {
+      BusyWait(absl::Milliseconds(2));
+      if (--remaining == 0) done.Notify();
+    });
+  }
+  done.WaitForNotification();
+  // The last task is accounted for after it returns.
+  while (busy_shared->tasks_run() < 10) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  EXPECT_GE(busy_shared->cpu_time(), absl::Milliseconds(10));
+  EXPECT_EQ(0, idle_shared->tasks_run());
+  EXPECT_EQ(absl::ZeroDuration(), idle_shared->cpu_time());
+}
+
+TEST(SharedExecutorTest, SharesThreadsByWeight) {
+  auto gate = CreateSharedExecutor("shares_by_weight", 1, 1);
+  auto heavy = CreateSharedExecutor("shares_by_weight", 1, 3);
+  auto light = CreateSharedExecutor("shares_by_weight", 1, 1);
+  absl::Notification open;
+  gate->Schedule([&open] { open.WaitForNotification(); });
+
+  // Both executors queue up more work than they get while the other one
+  // competes.
+  absl::Mutex mutex;
+  std::vector<char> order;
+  constexpr int kTasks = 200;
+  for (int i = 0; i < kTasks; ++i) {
+    heavy->Schedule([&] {
+      BusyWait(absl::Microseconds(200));
+      absl::MutexLock lock(&mutex);
+      order.push_back('h');
+    });
+    light->Schedule([&] {
+      BusyWait(absl::Microseconds(200));
+      absl::MutexLock lock(&mutex);
+      order.push_back('l');
+    });
+  }
+  open.Notify();
+  heavy.reset();
+  light.reset();
+
+  ASSERT_EQ(2 * kTasks, order.size());
+  // Over the first half, heavy gets about three quarters of the tasks.
+  int heavy_tasks = 0;
+  for (int i = 0; i < kTasks; ++i) {
+    heavy_tasks += order[i] == 'h';
+  }
+  EXPECT_GT(heavy_tasks, kTasks * 6 / 10);
+  EXPECT_LT(heavy_tasks, kTasks * 9 / 10);
+}
+
+TEST(SharedExecutorTest, LimitsConcurrency) {
+  auto executor = CreateSharedExecutor("limits_concurrency", 4, 1, 2);
+  std::atomic<int> running(0);
+  std::atomic<int> max_running(0);
+  for (int i = 0; i < 40; ++i) {
+    executor->Schedule([&] {
+      int now = ++running;
+      int max = max_running.load();
+      while (now > max && !max_running.compare_exchange_weak(max, now)) {
+      }
+      absl::SleepFor(absl::Milliseconds(1));
+      --running;
+    });
+  }
+  executor.reset();
+  EXPECT_EQ(2, max_running);
+}
+
+class AddOneCalculator : public CalculatorBase {
+ public:
+  static absl::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).Set<int>();
+    cc->Outputs().Index(0).Set<int>();
+    return absl::OkStatus();
+  }
+  absl::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<int>(cc->Inputs().Index(0).Get<int>() + 1)
+            .At(cc->InputTimestamp()));
+    return absl::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(AddOneCalculator);
+
+TEST(SharedExecutorTest, GraphsShareOnePool) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          type: 'SharedExecutor'
+          options {
+            [mediapipe.SharedExecutorOptions.ext] {
+              pool_name: 'graphs_share_one_pool'
+              weight: 2
+            }
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 2 }
+          }
+        }
+        node {
+          calculator: 'AddOneCalculator'
+          input_stream: 'in'
+          output_stream: 'mid'
+        }
+        node {
+          calculator: 'AddOneCalculator'
+          input_stream: 'mid'
+          output_stream: 'out'
+        }
+      )pb");
+  CalculatorGraph graphs[2];
+  std::vector<Packet> out_packets[2];
+  for (int g = 0; g < 2; ++g) {
+    MP_ASSERT_OK(graphs[g].Initialize(config));
+    MP_ASSERT_OK(graphs[g].ObserveOutputStream(
+        "out", [&out_packets, g](const Packet& packet) {
+          out_packets[g].push_back(packet);
+          return absl::OkStatus();
+        }));
+    MP_ASSERT_OK(graphs[g].StartRun({}));
+  }
+  for (int i = 0; i < 100; ++i) {
+    for (int g = 0; g < 2; ++g) {
+      MP_ASSERT_OK(graphs[g].AddPacketToInputStream(
+          "in", MakePacket<int>(i).At(Timestamp(i))));
+    }
+  }
+  for (int g = 0; g < 2; ++g) {
+    MP_ASSERT_OK(graphs[g].CloseAllInputStreams());
+    MP_ASSERT_OK(graphs[g].WaitUntilDone());
+    ASSERT_EQ(100, out_packets[g].size());
+    EXPECT_EQ(101, out_packets[g].back().Get<int>());
+    // Every node invocation is a task, along with opening and closing them.
+    EXPECT_GE(graphs[g].GetCounterFactory()
+                  ->GetCounter("SharedExecutorTasks")
+                  ->Get(),
+              150);
+  }
+}
+
+TEST(SharedExecutorDeathTest, DiesWhenDestroyedByItsOwnTask) {
+  EXPECT_DEATH(
+      {
+        Executor* executor =
+            CreateSharedExecutor("destroyed_by_task", 2, 1).release();
+        executor->Schedule([executor] { delete executor; });
+        absl::SleepFor(absl::Seconds(10));
+      },
+      "destroyed by one of its own tasks");
+}
+
+}  // namespace
+}  // namespace mediapipe
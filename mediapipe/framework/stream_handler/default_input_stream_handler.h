@@ -46,6 +46,7 @@ class DefaultInputStreamHandler : public InputStreamHandler {
   // - the minimum bound (over all empty streams) is greater than the smallest
   //   timestamp of any stream, which means we have received all the packets
   //   that will be available at the next timestamp.
+  // The stream bounds are read without locking the input streams.
   NodeReadiness GetNodeReadiness(Timestamp* min_stream_timestamp) override;
 
   // Only invoked when associated GetNodeReadiness() returned kReadyForProcess.
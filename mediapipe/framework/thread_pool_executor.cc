@@ -19,14 +19,17 @@
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 #include "mediapipe/util/cpu_util.h"
 
 namespace mediapipe {
 
-// static
-absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
-    const MediaPipeOptions& extendable_options) {
+namespace internal {
+
+absl::Status GetThreadPoolOptions(const MediaPipeOptions& extendable_options,
+                                  ThreadOptions* thread_options,
+                                  int* num_threads) {
   auto& options =
       extendable_options.GetExtension(ThreadPoolExecutorOptions::ext);
   if (!options.has_num_threads()) {
@@ -40,7 +43,6 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
            << options.num_threads();
   }
 
-  ThreadOptions thread_options;
   if (options.has_stack_size()) {
     // thread_options.set_stack_size() takes a size_t as input, so we must not
     // pass a negative value. 0 has a special meaning (the default thread
@@ -51,27 +53,40 @@ absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
                 "positive but is "
              << options.stack_size();
     }
-    thread_options.set_stack_size(options.stack_size());
+    thread_options->set_stack_size(options.stack_size());
   }
   if (options.has_nice_priority_level()) {
-    thread_options.set_nice_priority_level(options.nice_priority_level());
+    thread_options->set_nice_priority_level(options.nice_priority_level());
   }
   if (options.has_thread_name_prefix()) {
-    thread_options.set_name_prefix(options.thread_name_prefix());
+    thread_options->set_name_prefix(options.thread_name_prefix());
   }
 #if defined(__linux__)
   switch (options.require_processor_performance()) {
     case ThreadPoolExecutorOptions::LOW:
-      thread_options.set_cpu_set(InferLowerCoreIds());
+      thread_options->set_cpu_set(InferLowerCoreIds());
       break;
     case ThreadPoolExecutorOptions::HIGH:
-      thread_options.set_cpu_set(InferHigherCoreIds());
+      thread_options->set_cpu_set(InferHigherCoreIds());
       break;
     default:
       break;
   }
 #endif
-  return new ThreadPoolExecutor(thread_options, options.num_threads());
+  *num_threads = options.num_threads();
+  return absl::OkStatus();
+}
+
+}  // namespace internal
+
+// static
+absl::StatusOr<Executor*> ThreadPoolExecutor::Create(
+    const MediaPipeOptions& extendable_options) {
+  ThreadOptions thread_options;
+  int num_threads;
+  MP_RETURN_IF_ERROR(internal::GetThreadPoolOptions(
+      extendable_options, &thread_options, &num_threads));
+  return new ThreadPoolExecutor(thread_options, num_threads);
 }
 
 ThreadPoolExecutor::ThreadPoolExecutor(int num_threads)
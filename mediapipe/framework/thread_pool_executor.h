@@ -58,6 +58,16 @@ class ThreadPoolExecutor : public Executor {
   size_t stack_size_ = 0;
 };
 
+namespace internal {
+
+// Validates the ThreadPoolExecutorOptions extension of extendable_options and
+// converts it to the options and size of a thread pool.
+absl::Status GetThreadPoolOptions(const MediaPipeOptions& extendable_options,
+                                  ThreadOptions* thread_options,
+                                  int* num_threads);
+
+}  // namespace internal
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_THREAD_POOL_EXECUTOR_H_
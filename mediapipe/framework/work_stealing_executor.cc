@@ -0,0 +1,182 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/work_stealing_executor.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Times an idle worker looks for a task before it goes to sleep.
+constexpr int kSpinRounds = 64;
+
+// The executor and index of the worker running on the current thread.
+thread_local const WorkStealingExecutor* current_executor = nullptr;
+thread_local int current_worker = 0;
+
+}  // namespace
+
+// static
+absl::StatusOr<Executor*> WorkStealingExecutor::Create(
+    const MediaPipeOptions& extendable_options) {
+  ThreadOptions thread_options;
+  int num_threads;
+  MP_RETURN_IF_ERROR(internal::GetThreadPoolOptions(
+      extendable_options, &thread_options, &num_threads));
+  return new WorkStealingExecutor(thread_options, num_threads);
+}
+
+WorkStealingExecutor::WorkStealingExecutor(int num_threads)
+    : WorkStealingExecutor(ThreadOptions(), num_threads) {}
+
+WorkStealingExecutor::WorkStealingExecutor(const ThreadOptions& thread_options,
+                                           int num_threads)
+    : thread_pool_(thread_options,
+                   thread_options.name_prefix().empty()
+                       ? "mediapipe"
+                       : thread_options.name_prefix(),
+                   num_threads) {
+  for (int i = 0; i < thread_pool_.num_threads(); ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+  }
+  // Polling beyond the cores only takes time from the workers with tasks.
+  max_spinning_ = std::max(
+      1, std::min(thread_pool_.num_threads(), NumCPUCores()) / 2);
+  thread_pool_.StartWorkers();
+  // Each pool thread picks up one of these loops and keeps it until the end.
+  for (int i = 0; i < thread_pool_.num_threads(); ++i) {
+    thread_pool_.Schedule([this, i] { RunWorker(i); });
+  }
+  VLOG(2) << "Started work stealing executor with "
+          << thread_pool_.num_threads() << " threads.";
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  VLOG(2) << "Terminating work stealing executor.";
+  absl::MutexLock lock(&sleep_mutex_);
+  stopped_ = true;
+  wake_up_.SignalAll();
+}
+
+void WorkStealingExecutor::Schedule(std::function<void()> task) {
+  int index = current_executor == this
+                  ? current_worker
+                  : next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                        workers_.size();
+  {
+    Worker& worker = *workers_[index];
+    absl::MutexLock lock(&worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+  }
+  // Pairs with WaitForTask: either a polling or sleeping worker sees the new
+  // task, or the task is seen to have no poller and a sleeper to wake up.
+  num_queued_.fetch_add(1);
+  if (num_spinning_.load() == 0 && num_sleeping_.load() > 0) {
+    WakeUpWorker();
+  }
+}
+
+void WorkStealingExecutor::RunWorker(int index) {
+  current_executor = this;
+  current_worker = index;
+  std::function<void()> task;
+  while (true) {
+    if (TakeTask(index, &task)) {
+      // Tasks scheduled while nobody polled may have woken up a single worker,
+      // so every worker that finds a task passes the wake-up on.
+      if (num_queued_.load() > 0 && num_spinning_.load() == 0 &&
+          num_sleeping_.load() > 0) {
+        WakeUpWorker();
+      }
+      task();
+      task = nullptr;
+    } else if (!WaitForTask()) {
+      break;
+    }
+  }
+  current_executor = nullptr;
+}
+
+bool WorkStealingExecutor::TakeTask(int index, std::function<void()>* task) {
+  {
+    Worker& worker = *workers_[index];
+    absl::MutexLock lock(&worker.mutex);
+    if (!worker.tasks.empty()) {
+      *task = std::move(worker.tasks.back());
+      worker.tasks.pop_back();
+      worker.size.store(worker.tasks.size(), std::memory_order_relaxed);
+      num_queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  const int n = num_threads();
+  for (int i = 1; i < n; ++i) {
+    Worker& victim = *workers_[(index + i) % n];
+    if (victim.size.load(std::memory_order_relaxed) == 0) {
+      continue;
+    }
+    absl::MutexLock lock(&victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      victim.size.store(victim.tasks.size(), std::memory_order_relaxed);
+      num_queued_.fetch_sub(1);
+      num_steals_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool WorkStealingExecutor::WaitForTask() {
+  // A task scheduled by a running node usually follows shortly, so polling
+  // for a while is cheaper than a sleep and a wake-up.
+  if (num_spinning_.fetch_add(1) < max_spinning_) {
+    for (int i = 0; i < kSpinRounds; ++i) {
+      if (num_queued_.load() > 0) {
+        num_spinning_.fetch_sub(1);
+        return true;
+      }
+      std::this_thread::yield();
+    }
+  }
+  num_spinning_.fetch_sub(1);
+  absl::MutexLock lock(&sleep_mutex_);
+  num_sleeping_.fetch_add(1);
+  while (num_queued_.load() == 0 && !stopped_) {
+    wake_up_.Wait(&sleep_mutex_);
+  }
+  num_sleeping_.fetch_sub(1);
+  return num_queued_.load() > 0 || !stopped_;
+}
+
+void WorkStealingExecutor::WakeUpWorker() {
+  absl::MutexLock lock(&sleep_mutex_);
+  wake_up_.Signal();
+}
+
+REGISTER_EXECUTOR(WorkStealingExecutor);
+
+}  // namespace mediapipe
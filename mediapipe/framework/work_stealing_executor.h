@@ -0,0 +1,108 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+
+namespace mediapipe {
+
+// A multithreaded executor in which every worker thread owns a task deque.
+// A task scheduled from a worker goes to that worker's deque, and the worker
+// runs its newest task first, so a node scheduled by its upstream node tends
+// to run on the same core while the upstream outputs are still in cache. A
+// task scheduled from any other thread goes to the deques in turn. A worker
+// whose deque is empty steals the oldest task of another worker. When no deque
+// has a task left, a few workers keep polling for a short while and the
+// others sleep; a sleeping worker is only woken up when no worker is polling.
+//
+// Node priority is unaffected: the scheduler queue hands the executor
+// interchangeable tasks, each of which runs the highest priority node ready
+// at the time it starts.
+//
+// Selected with ExecutorConfig type "WorkStealingExecutor", and configured
+// with the same ThreadPoolExecutorOptions as ThreadPoolExecutor.
+class WorkStealingExecutor : public Executor {
+ public:
+  static absl::StatusOr<Executor*> Create(
+      const MediaPipeOptions& extendable_options);
+
+  explicit WorkStealingExecutor(int num_threads);
+  // Runs the remaining tasks before returning.
+  ~WorkStealingExecutor() override;
+  void Schedule(std::function<void()> task) override;
+
+  // For testing.
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+  // Number of tasks a worker took from the deque of another worker.
+  int64_t num_steals() const {
+    return num_steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // Padded so that workers do not share cache lines.
+  struct alignas(64) Worker {
+    absl::Mutex mutex;
+    std::deque<std::function<void()>> tasks ABSL_GUARDED_BY(mutex);
+    // Size of tasks, read without the mutex to skip empty deques.
+    std::atomic<int> size{0};
+  };
+
+  WorkStealingExecutor(const ThreadOptions& thread_options, int num_threads);
+
+  // Runs worker index until the executor stops and every deque is empty.
+  void RunWorker(int index);
+  // Takes the newest task of worker index, or else the oldest task of another
+  // worker. Returns false when every deque was empty.
+  bool TakeTask(int index, std::function<void()>* task);
+  // Blocks until a task may be available. Returns false once the executor
+  // stops with no task left.
+  bool WaitForTask();
+  // Wakes up one sleeping worker, if any.
+  void WakeUpWorker();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  // Tasks scheduled and not yet taken by a worker.
+  std::atomic<int64_t> num_queued_{0};
+  std::atomic<int> num_sleeping_{0};
+  // Idle workers polling for a task before they sleep, at most max_spinning_.
+  std::atomic<int> num_spinning_{0};
+  int max_spinning_ = 1;
+  std::atomic<uint32_t> next_worker_{0};
+  std::atomic<int64_t> num_steals_{0};
+
+  absl::Mutex sleep_mutex_;
+  absl::CondVar wake_up_;
+  bool stopped_ ABSL_GUARDED_BY(sleep_mutex_) = false;
+
+  // Runs one RunWorker loop per thread. Declared last, so that its destructor
+  // joins the threads before the deques are destroyed.
+  mediapipe::ThreadPool thread_pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_WORK_STEALING_EXECUTOR_H_
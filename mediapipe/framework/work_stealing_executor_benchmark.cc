@@ -0,0 +1,102 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Scheduling throughput of ThreadPoolExecutor and WorkStealingExecutor
+// against the number of threads, e.g.
+//   bazel run -c opt //mediapipe/framework:work_stealing_executor_benchmark
+
+#include <atomic>
+#include <functional>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/framework/work_stealing_executor.h"
+
+namespace mediapipe {
+namespace {
+
+// Tasks per benchmark iteration.
+constexpr int kTasks = 1 << 14;
+
+// Stands in for a cheap calculator, so that scheduling dominates.
+void Work() {
+  int sum = 0;
+  for (int i = 0; i < 64; ++i) {
+    benchmark::DoNotOptimize(sum += i);
+  }
+}
+
+// The application thread schedules every task, like packets added to graph
+// input streams.
+template <typename ExecutorType>
+void BM_ScheduleFromOutside(benchmark::State& state) {
+  ExecutorType executor(state.range(0));
+  for (auto _ : state) {
+    absl::BlockingCounter done(kTasks);
+    for (int i = 0; i < kTasks; ++i) {
+      executor.Schedule([&done] {
+        Work();
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+// Every task schedules its successor, like a node scheduling its downstream
+// node. Two chains per thread keep all threads busy.
+template <typename ExecutorType>
+void BM_ScheduleFromTasks(benchmark::State& state) {
+  const int num_chains = 2 * state.range(0);
+  const int chain_length = kTasks / num_chains;
+  ExecutorType executor(state.range(0));
+  for (auto _ : state) {
+    absl::BlockingCounter done(num_chains);
+    std::function<void(int)> step = [&](int remaining) {
+      Work();
+      if (remaining > 1) {
+        executor.Schedule([&step, remaining] { step(remaining - 1); });
+      } else {
+        done.DecrementCount();
+      }
+    };
+    for (int i = 0; i < num_chains; ++i) {
+      executor.Schedule([&step, chain_length] { step(chain_length); });
+    }
+    done.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * num_chains * chain_length);
+}
+
+BENCHMARK_TEMPLATE(BM_ScheduleFromOutside, ThreadPoolExecutor)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleFromOutside, WorkStealingExecutor)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleFromTasks, ThreadPoolExecutor)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ScheduleFromTasks, WorkStealingExecutor)
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,132 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/work_stealing_executor.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(WorkStealingExecutorTest, RunsAllTasksBeforeDestruction) {
+  std::atomic<int> count(0);
+  {
+    WorkStealingExecutor executor(4);
+    ASSERT_EQ(4, executor.num_threads());
+    for (int i = 0; i < 1000; ++i) {
+      executor.Schedule([&count] { ++count; });
+    }
+  }
+  EXPECT_EQ(1000, count);
+}
+
+TEST(WorkStealingExecutorTest, RunsTasksScheduledByTasks) {
+  std::atomic<int> count(0);
+  // Declared first, since the executor destructor still runs chain.
+  std::function<void(int)> chain;
+  {
+    WorkStealingExecutor executor(3);
+    chain = [&](int depth) {
+      ++count;
+      if (depth > 0) {
+        executor.Schedule([&chain, depth] { chain(depth - 1); });
+      }
+    };
+    for (int i = 0; i < 10; ++i) {
+      executor.Schedule([&chain] { chain(99); });
+    }
+  }
+  EXPECT_EQ(1000, count);
+}
+
+TEST(WorkStealingExecutorTest, IdleWorkerStealsFromBusyWorker) {
+  absl::Notification stolen_task_ran;
+  WorkStealingExecutor executor(2);
+  executor.Schedule([&] {
+    // Queued behind this task on the same worker, so only the other worker
+    // can run it while this one waits.
+    executor.Schedule([&] { stolen_task_ran.Notify(); });
+    stolen_task_ran.WaitForNotification();
+  });
+  stolen_task_ran.WaitForNotification();
+  EXPECT_GE(executor.num_steals(), 1);
+}
+
+TEST(WorkStealingExecutorTest, CreateUsesThreadPoolExecutorOptions) {
+  MediaPipeOptions options;
+  options.MutableExtension(ThreadPoolExecutorOptions::ext)->set_num_threads(3);
+  auto executor_or = WorkStealingExecutor::Create(options);
+  MP_ASSERT_OK(executor_or);
+  std::unique_ptr<Executor> executor(executor_or.value());
+  EXPECT_EQ(3,
+            static_cast<WorkStealingExecutor*>(executor.get())->num_threads());
+
+  options.MutableExtension(ThreadPoolExecutorOptions::ext)->set_num_threads(0);
+  EXPECT_EQ(WorkStealingExecutor::Create(options).status().code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(WorkStealingExecutorTest, RunsGraphAsDefaultExecutor) {
+  CalculatorGraphConfig config =
+      mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"pb(
+        input_stream: 'in'
+        executor {
+          type: 'WorkStealingExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 4 }
+          }
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'in'
+          output_stream: 'mid'
+        }
+        node {
+          calculator: 'PassThroughCalculator'
+          input_stream: 'mid'
+          output_stream: 'out'
+        }
+      )pb");
+  CalculatorGraph graph;
+  MP_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> out_packets;
+  MP_ASSERT_OK(graph.ObserveOutputStream("out", [&](const Packet& packet) {
+    out_packets.push_back(packet);
+    return absl::OkStatus();
+  }));
+  MP_ASSERT_OK(graph.StartRun({}));
+  for (int i = 0; i < 100; ++i) {
+    MP_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MP_ASSERT_OK(graph.CloseAllInputStreams());
+  MP_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(100, out_packets.size());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, out_packets[i].Get<int>());
+  }
+}
+
+}  // namespace
+}  // namespace mediapipe
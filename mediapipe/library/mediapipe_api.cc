@@ -1,196 +1,699 @@
 #include "mediapipe_api.h"
+#include "mediapipe_graph_util.hpp"
 #include "mediapipe_interface.hpp"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 
-FaceMeshInterface* face_mesh_interface = nullptr;
-HandTrackInterface* hand_track_interface = nullptr;
-PoseTrackInterface* pose_track_interface = nullptr;
-HolisticTrackInterface* holistic_track_interface = nullptr;
-FaceBlendShapeInterface* face_blend_shape_interface = nullptr;
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace {
+
+const MpOptions kDefaultOptions{};
+
+thread_local std::string last_error_message;
+
+MpStatus ToMpStatus(absl::StatusCode code) {
+    switch (code) {
+        case absl::StatusCode::kOk:
+            return MP_OK;
+        case absl::StatusCode::kInvalidArgument:
+            return MP_INVALID_ARGUMENT;
+        case absl::StatusCode::kNotFound:
+            return MP_NOT_FOUND;
+        case absl::StatusCode::kFailedPrecondition:
+            return MP_FAILED_PRECONDITION;
+        case absl::StatusCode::kUnavailable:
+            return MP_UNAVAILABLE;
+        default:
+            return MP_INTERNAL;
+    }
+}
+
+// Runs call and turns every exception into a status code, since none may
+// cross the C boundary. The message is kept for GetLastErrorMessage.
+template <typename F>
+MpStatus Guard(F&& call) {
+    try {
+        if constexpr (std::is_void_v<decltype(call())>) {
+            call();
+            return MP_OK;
+        } else {
+            return call();
+        }
+    } catch (const StatusError& e) {
+        last_error_message = e.what();
+        return ToMpStatus(e.status().code());
+    } catch (const std::invalid_argument& e) {
+        last_error_message = e.what();
+        return MP_INVALID_ARGUMENT;
+    } catch (const std::exception& e) {
+        last_error_message = e.what();
+        return MP_INTERNAL;
+    } catch (...) {
+        last_error_message = "unknown error";
+        return MP_INTERNAL;
+    }
+}
+
+template <typename T>
+T& Deref(T* pointer) {
+    if (!pointer) {
+        throw std::invalid_argument("null pointer argument");
+    }
+    return *pointer;
+}
+
+TraceReader* FromTraceHandle(MpTraceHandle trace) {
+    if (!trace) {
+        throw std::invalid_argument("invalid MpTraceHandle");
+    }
+    return static_cast<TraceReader*>(trace);
+}
+
+// Throws the status of a failed trace call.
+void CheckStatus(const absl::Status& status) {
+    if (!status.ok()) {
+        throw StatusError(status);
+    }
+}
+
+template <typename T>
+T* FromHandle(MpHandle handle) {
+    auto interface = dynamic_cast<T*>(static_cast<MediapipeInterface*>(handle));
+    if (!interface) {
+        throw std::invalid_argument("invalid MpHandle");
+    }
+    return interface;
+}
+
+template <typename T>
+MpStatus CreateInterface(const char* graph_name, const MpOptions* options, MpHandle* handle) {
+    return Guard([&] {
+        if (!graph_name) {
+            throw std::invalid_argument("null graph_name");
+        }
+        auto interface = std::make_unique<T>();
+        interface->SetGraph(graph_name, options ? *options : kDefaultOptions);
+        Deref(handle) = static_cast<MediapipeInterface*>(interface.release());
+    });
+}
+
+template <typename T, typename Value>
+MpStatus TryGetLatest(MpHandle handle, Value* list, unsigned size, long long timeout_us, unsigned* written, long long* timestamp_us) {
+    return Guard([&] {
+        int64_t timestamp = 0;
+        auto count = FromHandle<T>(handle)->TryGetLatest(list, size, timeout_us, &timestamp);
+        if (count < 0) {
+            return MP_UNAVAILABLE;
+        }
+        if (written) {
+            *written = count;
+        }
+        if (timestamp_us) {
+            *timestamp_us = timestamp;
+        }
+        return MP_OK;
+    });
+}
+
+}  // namespace
+
+LibraryExport const char* GetLastErrorMessage() {
+    return last_error_message.c_str();
+}
+
+LibraryExport MpStatus CompileGraph(const char * graph_name, const char * output_path) {
+    return Guard([&] {
+        if (!graph_name || !output_path) {
+            throw std::invalid_argument("null graph_name or output_path");
+        }
+        CheckStatus(CompileGraphConfig(graph_name, output_path));
+    });
+}
+
+LibraryExport MpStatus RecordTrace(MpHandle handle, const char* path) {
+    return Guard([&] {
+        if (!path) {
+            throw std::invalid_argument("null path");
+        }
+        FromHandle<MediapipeInterface>(handle)->Record(path);
+    });
+}
+
+LibraryExport MpStatus OpenTrace(const char* path, MpTraceHandle* trace) {
+    return Guard([&] {
+        if (!path) {
+            throw std::invalid_argument("null path");
+        }
+        auto& out = Deref(trace);
+        auto reader = std::make_unique<TraceReader>();
+        CheckStatus(reader->Open(path));
+        out = reader.release();
+    });
+}
+
+LibraryExport MpStatus CloseTrace(MpTraceHandle trace) {
+    return Guard([&] {
+        delete FromTraceHandle(trace);
+    });
+}
+
+LibraryExport MpStatus GetTraceInfo(MpTraceHandle trace, MpTraceInfo* info) {
+    return Guard([&] {
+        Deref(info) = FromTraceHandle(trace)->Info();
+    });
+}
+
+LibraryExport MpStatus GetTraceChannel(MpTraceHandle trace, unsigned channel, MpTraceChannel* info) {
+    return Guard([&] {
+        CheckStatus(FromTraceHandle(trace)->Channel(channel, &Deref(info)));
+    });
+}
+
+LibraryExport MpStatus FindTraceFrame(MpTraceHandle trace, long long timestamp_us, unsigned long long* index) {
+    return Guard([&] {
+        uint64_t found = 0;
+        CheckStatus(FromTraceHandle(trace)->Find(timestamp_us, &found));
+        Deref(index) = found;
+    });
+}
+
+LibraryExport MpStatus GetTraceTimestamp(MpTraceHandle trace, unsigned long long index, long long* timestamp_us) {
+    return Guard([&] {
+        int64_t timestamp = 0;
+        CheckStatus(FromTraceHandle(trace)->Timestamp(index, &timestamp));
+        Deref(timestamp_us) = timestamp;
+    });
+}
+
+LibraryExport MpStatus GetTraceValues(MpTraceHandle trace, unsigned long long index, unsigned channel, unsigned slot, const float** values) {
+    return Guard([&] {
+        CheckStatus(FromTraceHandle(trace)->Values(index, channel, slot, &Deref(values)));
+    });
+}
+
+LibraryExport MpStatus GetTraceColumn(MpTraceHandle trace, unsigned long long index, unsigned channel, const long long** timestamps, const float** values, unsigned long long* count) {
+    static_assert(sizeof(long long) == sizeof(int64_t), "trace timestamps are int64");
+    return Guard([&] {
+        const int64_t* column_timestamps = nullptr;
+        uint64_t column_count = 0;
+        CheckStatus(FromTraceHandle(trace)->Column(index, channel, &column_timestamps, &Deref(values), &column_count));
+        Deref(timestamps) = reinterpret_cast<const long long*>(column_timestamps);
+        Deref(count) = column_count;
+    });
+}
+
+LibraryExport MpStatus CreateFaceMeshInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<FaceMeshInterface>(graph_name, options, handle);
+}
+
+LibraryExport MpStatus ReleaseFaceMeshInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<FaceMeshInterface>(handle);
+    });
+}
+
+LibraryExport MpStatus StartFaceMesh(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->Start();
+    });
+}
+
+LibraryExport MpStatus FaceMeshProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<FaceMeshInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus FaceMeshProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceMeshInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus FaceMeshProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceMeshInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus SetFaceMeshObserveCallback(MpHandle handle, landmark_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->SetObserveCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus SetFaceMeshResultCallback(MpHandle handle, landmark_result_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->SetResultCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus ObserveFaceMesh(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->Observe();
+    });
+}
+
+LibraryExport MpStatus AddFaceMeshPoller(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->AddOutputStreamPoller();
+    });
+}
+
+LibraryExport MpStatus GetFaceMeshOutput(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->GetOutput(normalized_landmark_list, size);
+    });
+}
+
+LibraryExport MpStatus TryGetFaceMeshLatest(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size, long long timeout_us, unsigned * written, long long * timestamp_us) {
+    return TryGetLatest<FaceMeshInterface>(handle, normalized_landmark_list, size, timeout_us, written, timestamp_us);
+}
+
+LibraryExport MpStatus StopFaceMesh(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshInterface>(handle)->Stop();
+    });
+}
+
+LibraryExport MpStatus GetFaceMeshQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceMeshInterface>(handle)->QueueStats();
+    });
+}
+
+LibraryExport MpStatus GetFaceMeshStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceMeshInterface>(handle)->Stats();
+    });
+}
+
+LibraryExport MpStatus CreateHandTrackInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<HandTrackInterface>(graph_name, options, handle);
+}
+
+LibraryExport MpStatus ReleaseHandTrackInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<HandTrackInterface>(handle);
+    });
+}
+
+LibraryExport MpStatus StartHandTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->Start();
+    });
+}
+
+LibraryExport MpStatus HandTrackProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<HandTrackInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus HandTrackProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<HandTrackInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus HandTrackProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<HandTrackInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus SetHandTrackObserveCallback(MpHandle handle, landmark_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->SetObserveCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus SetHandTrackResultCallback(MpHandle handle, landmark_result_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->SetResultCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus ObserveHandTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->Observe();
+    });
+}
+
+LibraryExport MpStatus AddHandTrackPoller(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->AddOutputStreamPoller();
+    });
+}
+
+LibraryExport MpStatus GetHandTrackOutput(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->GetOutput(normalized_landmark_list, size);
+    });
+}
+
+LibraryExport MpStatus TryGetHandTrackLatest(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size, long long timeout_us, unsigned * written, long long * timestamp_us) {
+    return TryGetLatest<HandTrackInterface>(handle, normalized_landmark_list, size, timeout_us, written, timestamp_us);
+}
+
+LibraryExport MpStatus StopHandTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HandTrackInterface>(handle)->Stop();
+    });
+}
+
+LibraryExport MpStatus GetHandTrackQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<HandTrackInterface>(handle)->QueueStats();
+    });
+}
+
+LibraryExport MpStatus GetHandTrackStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<HandTrackInterface>(handle)->Stats();
+    });
+}
+
+LibraryExport MpStatus CreatePoseTrackInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<PoseTrackInterface>(graph_name, options, handle);
+}
+
+LibraryExport MpStatus ReleasePoseTrackInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<PoseTrackInterface>(handle);
+    });
+}
+
+LibraryExport MpStatus StartPoseTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->Start();
+    });
+}
+
+LibraryExport MpStatus PoseTrackProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<PoseTrackInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus PoseTrackProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<PoseTrackInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus PoseTrackProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<PoseTrackInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
+}
+
+LibraryExport MpStatus SetPoseTrackObserveCallback(MpHandle handle, landmark_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->SetObserveCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus SetPoseTrackResultCallback(MpHandle handle, landmark_result_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->SetResultCallback(callback, user_data);
+    });
+}
+
+LibraryExport MpStatus ObservePoseTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->Observe();
+    });
+}
+
+LibraryExport MpStatus AddPoseTrackPoller(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->AddOutputStreamPoller();
+    });
+}
 
-LibraryExport void CreateFaceMeshInterface(const char * graph_name) {
-    face_mesh_interface = new FaceMeshInterface();
-    face_mesh_interface->SetGraph(graph_name);
+LibraryExport MpStatus GetPoseTrackOutput(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->GetOutput(normalized_landmark_list, size);
+    });
 }
 
-LibraryExport void ReleaseFaceMeshInterface() {
-    delete face_mesh_interface;
-    face_mesh_interface = nullptr;
+LibraryExport MpStatus TryGetPoseTrackLatest(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned size, long long timeout_us, unsigned * written, long long * timestamp_us) {
+    return TryGetLatest<PoseTrackInterface>(handle, normalized_landmark_list, size, timeout_us, written, timestamp_us);
 }
 
-LibraryExport void StartFaceMesh() {
-    face_mesh_interface->Start();
+LibraryExport MpStatus StopPoseTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<PoseTrackInterface>(handle)->Stop();
+    });
 }
 
-LibraryExport void FaceMeshProcess(void * mat) {
-    auto cpp_mat = static_cast<cv::Mat*>(mat);
-    face_mesh_interface->Process(*cpp_mat);
+LibraryExport MpStatus GetPoseTrackQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<PoseTrackInterface>(handle)->QueueStats();
+    });
 }
 
-LibraryExport void SetFaceMeshObserveCallback(landmark_callback callback) {
-    face_mesh_interface->SetObserveCallback(callback);
+LibraryExport MpStatus GetPoseTrackStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<PoseTrackInterface>(handle)->Stats();
+    });
 }
 
-LibraryExport void ObserveFaceMesh() {
-    face_mesh_interface->Observe();
+LibraryExport MpStatus CreateHolisticTrackInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<HolisticTrackInterface>(graph_name, options, handle);
 }
 
-LibraryExport void AddFaceMeshPoller() {
-    face_mesh_interface->AddOutputStreamPoller();
+LibraryExport MpStatus ReleaseHolisticTrackInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<HolisticTrackInterface>(handle);
+    });
 }
 
-LibraryExport void GetFaceMeshOutput(NormalizedLandmark * normalized_landmark_list, unsigned size) {
-    face_mesh_interface->GetOutput(normalized_landmark_list, size);
+LibraryExport MpStatus StartHolisticTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HolisticTrackInterface>(handle)->Start();
+    });
 }
 
-LibraryExport void StopFaceMesh() {
-    face_mesh_interface->Stop();
+LibraryExport MpStatus HolisticTrackProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<HolisticTrackInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void CreateHandTrackInterface(const char * graph_name) {
-    hand_track_interface = new HandTrackInterface();
-    hand_track_interface->SetGraph(graph_name);
+LibraryExport MpStatus HolisticTrackProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<HolisticTrackInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void ReleaseHandTrackInterface() {
-    delete hand_track_interface;
-    hand_track_interface = nullptr;
+LibraryExport MpStatus HolisticTrackProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<HolisticTrackInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void StartHandTrack() {
-    hand_track_interface->Start();
+LibraryExport MpStatus SetHolisticTrackObserveCallback(MpHandle handle, landmark_callback callback, HolisticCallbackType type, void * user_data) {
+    return Guard([&] {
+        FromHandle<HolisticTrackInterface>(handle)->SetObserveCallback(callback, type, user_data);
+    });
 }
 
-LibraryExport void HandTrackProcess(void * mat) {
-    auto cpp_mat = static_cast<cv::Mat*>(mat);
-    hand_track_interface->Process(*cpp_mat);
+LibraryExport MpStatus SetHolisticTrackResultCallback(MpHandle handle, holistic_result_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<HolisticTrackInterface>(handle)->SetResultCallback(callback, user_data);
+    });
 }
 
-LibraryExport void SetHandTrackObserveCallback(landmark_callback callback) {
-    hand_track_interface->SetObserveCallback(callback);
+LibraryExport MpStatus ObserveHolisticTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HolisticTrackInterface>(handle)->Observe();
+    });
 }
 
-LibraryExport void ObserveHandTrack() {
-    hand_track_interface->Observe();
+LibraryExport MpStatus StopHolisticTrack(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<HolisticTrackInterface>(handle)->Stop();
+    });
 }
 
-LibraryExport void AddHandTrackPoller() {
-    hand_track_interface->AddOutputStreamPoller();
+LibraryExport MpStatus GetHolisticTrackQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<HolisticTrackInterface>(handle)->QueueStats();
+    });
 }
 
-LibraryExport void GetHandTrackOutput(NormalizedLandmark * normalized_landmark_list, unsigned size) {
-    hand_track_interface->GetOutput(normalized_landmark_list, size);
+LibraryExport MpStatus GetHolisticTrackStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<HolisticTrackInterface>(handle)->Stats();
+    });
 }
 
-LibraryExport void StopHandTrack() {
-    hand_track_interface->Stop();
+LibraryExport MpStatus CreateFaceBlendShapeInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<FaceBlendShapeInterface>(graph_name, options, handle);
 }
 
-LibraryExport void CreatePoseTrackInterface(const char * graph_name) {
-    pose_track_interface = new PoseTrackInterface();
-    pose_track_interface->SetGraph(graph_name);
+LibraryExport MpStatus ReleaseFaceBlendShapeInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<FaceBlendShapeInterface>(handle);
+    });
 }
 
-LibraryExport void ReleasePoseTrackInterface() {
-    delete pose_track_interface;
-    pose_track_interface = nullptr;
+LibraryExport MpStatus StartFaceBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->Start();
+    });
 }
 
-LibraryExport void StartPoseTrack() {
-    pose_track_interface->Start();
+LibraryExport MpStatus FaceBlendShapeProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<FaceBlendShapeInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void PoseTrackProcess(void * mat) {
-    auto cpp_mat = static_cast<cv::Mat*>(mat);
-    pose_track_interface->Process(*cpp_mat);
+LibraryExport MpStatus FaceBlendShapeProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceBlendShapeInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void SetPoseTrackObserveCallback(landmark_callback callback) {
-    pose_track_interface->SetObserveCallback(callback);
+LibraryExport MpStatus FaceBlendShapeProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceBlendShapeInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void ObservePoseTrack() {
-    pose_track_interface->Observe();
+LibraryExport MpStatus SetFaceBlendShapeCallback(MpHandle handle, blend_shape_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->SetObserveCallback(callback, user_data);
+    });
 }
 
-LibraryExport void AddPoseTrackPoller() {
-    pose_track_interface->AddOutputStreamPoller();
+LibraryExport MpStatus ObserveFaceBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->Observe();
+    });
 }
 
-LibraryExport void GetPoseTrackOutput(NormalizedLandmark * normalized_landmark_list, unsigned size) {
-    pose_track_interface->GetOutput(normalized_landmark_list, size);
+LibraryExport MpStatus AddFaceBlendShapePoller(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->AddOutputStreamPoller();
+    });
 }
 
-LibraryExport void StopPoseTrack() {
-    pose_track_interface->Stop();
+LibraryExport MpStatus GetFaceBlendShapeOutput(MpHandle handle, float * blend_shape_list, unsigned size) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->GetOutput(blend_shape_list, size);
+    });
 }
 
-LibraryExport void CreateHolisticTrackInterface(const char * graph_name) {
-    holistic_track_interface = new HolisticTrackInterface();
-    holistic_track_interface->SetGraph(graph_name);
+LibraryExport MpStatus TryGetFaceBlendShapeLatest(MpHandle handle, float * blend_shape_list, unsigned size, long long timeout_us, unsigned * written, long long * timestamp_us) {
+    return TryGetLatest<FaceBlendShapeInterface>(handle, blend_shape_list, size, timeout_us, written, timestamp_us);
 }
 
-LibraryExport void ReleaseHolisticTrackInterface() {
-    delete holistic_track_interface;
-    holistic_track_interface = nullptr;
+LibraryExport MpStatus StopFaceBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceBlendShapeInterface>(handle)->Stop();
+    });
 }
 
-LibraryExport void StartHolisticTrack() {
-    holistic_track_interface->Start();
+LibraryExport MpStatus GetFaceBlendShapeQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceBlendShapeInterface>(handle)->QueueStats();
+    });
 }
 
-LibraryExport void HolisticTrackProcess(void * mat) {
-    auto cpp_mat = static_cast<cv::Mat*>(mat);
-    holistic_track_interface->Process(*cpp_mat);
+LibraryExport MpStatus GetFaceBlendShapeStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceBlendShapeInterface>(handle)->Stats();
+    });
 }
 
-LibraryExport void SetHolisticTrackObserveCallback(landmark_callback callback, HolisticCallbackType type) {
-    holistic_track_interface->SetObserveCallback(callback, type);
+LibraryExport MpStatus CreateFaceMeshBlendShapeInterface(const char * graph_name, const MpOptions * options, MpHandle * handle) {
+    return CreateInterface<FaceMeshBlendShapeInterface>(graph_name, options, handle);
 }
 
-LibraryExport void ObserveHolisticTrack() {
-    holistic_track_interface->Observe();
+LibraryExport MpStatus ReleaseFaceMeshBlendShapeInterface(MpHandle handle) {
+    return Guard([&] {
+        delete FromHandle<FaceMeshBlendShapeInterface>(handle);
+    });
 }
 
-LibraryExport void StopHolisticTrack() {
-    holistic_track_interface->Stop();
+LibraryExport MpStatus StartFaceMeshBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshBlendShapeInterface>(handle)->Start();
+    });
 }
 
-LibraryExport void CreateFaceBlendShapeInterface(const char * graph_name) {
-    face_blend_shape_interface  = new FaceBlendShapeInterface();
-    face_blend_shape_interface->SetGraph(graph_name);
+LibraryExport MpStatus FaceMeshBlendShapeProcess(MpHandle handle, void * mat) {
+    return Guard([&] {
+        auto& cpp_mat = Deref(static_cast<cv::Mat*>(mat));
+        return FromHandle<FaceMeshBlendShapeInterface>(handle)->Process(cpp_mat) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void ReleaseFaceBlendShapeInterface(){
-    delete face_blend_shape_interface;
-    face_blend_shape_interface = nullptr;
+LibraryExport MpStatus FaceMeshBlendShapeProcessImage(MpHandle handle, const MpImage * image, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceMeshBlendShapeInterface>(handle)->Process(Deref(image), release, user_data) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void StartFaceBlendShape() {
-    face_blend_shape_interface->Start();
+LibraryExport MpStatus FaceMeshBlendShapeProcessImageAt(MpHandle handle, const MpImage * image, long long timestamp_us, frame_release_callback release, void * user_data) {
+    return Guard([&] {
+        return FromHandle<FaceMeshBlendShapeInterface>(handle)->Process(Deref(image), release, user_data, timestamp_us) ? MP_OK : MP_UNAVAILABLE;
+    });
 }
 
-LibraryExport void FaceBlendShapeProcess(void * mat) {
-    auto cpp_mat = static_cast<cv::Mat*>(mat);
-    face_blend_shape_interface->Process(*cpp_mat);
+LibraryExport MpStatus SetFaceMeshBlendShapeResultCallback(MpHandle handle, face_result_callback callback, void * user_data) {
+    return Guard([&] {
+        FromHandle<FaceMeshBlendShapeInterface>(handle)->SetResultCallback(callback, user_data);
+    });
 }
 
-LibraryExport void SetFaceBlendShapeCallback(blend_shape_callback callback) {
-    face_blend_shape_interface->SetObserveCallback(callback);
+LibraryExport MpStatus ObserveFaceMeshBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshBlendShapeInterface>(handle)->Observe();
+    });
 }
 
-LibraryExport void ObserveFaceBlendShape() {
-    face_blend_shape_interface->Observe();
+LibraryExport MpStatus TryGetFaceMeshBlendShapeLatest(MpHandle handle, NormalizedLandmark * normalized_landmark_list, unsigned landmark_size, float * blend_shape_list, unsigned blend_shape_size, long long timeout_us, unsigned * landmarks_written, unsigned * blend_shapes_written, long long * timestamp_us) {
+    return Guard([&] {
+        int64_t timestamp = 0;
+        if (!FromHandle<FaceMeshBlendShapeInterface>(handle)->TryGetLatest(normalized_landmark_list, landmark_size, blend_shape_list, blend_shape_size, timeout_us,
+                                                                           landmarks_written, blend_shapes_written, &timestamp)) {
+            return MP_UNAVAILABLE;
+        }
+        if (timestamp_us) {
+            *timestamp_us = timestamp;
+        }
+        return MP_OK;
+    });
 }
 
-LibraryExport void AddFaceBlendShapePoller() {
-    face_blend_shape_interface->AddOutputStreamPoller();
+LibraryExport MpStatus StopFaceMeshBlendShape(MpHandle handle) {
+    return Guard([&] {
+        FromHandle<FaceMeshBlendShapeInterface>(handle)->Stop();
+    });
 }
 
-LibraryExport void GetFaceBlendShapeOutput(float * blend_shape_list, unsigned size) {
-    face_blend_shape_interface->GetOutput(blend_shape_list, size);
+LibraryExport MpStatus GetFaceMeshBlendShapeQueueStats(MpHandle handle, MpQueueStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceMeshBlendShapeInterface>(handle)->QueueStats();
+    });
 }
 
-LibraryExport void StopFaceBlendShape() {
-    face_blend_shape_interface->Stop();
+LibraryExport MpStatus GetFaceMeshBlendShapeStats(MpHandle handle, MpStats * stats) {
+    return Guard([&] {
+        Deref(stats) = FromHandle<FaceMeshBlendShapeInterface>(handle)->Stats();
+    });
 }
@@ -0,0 +1,59 @@
+#include "mediapipe_graph_util.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace {
+
+// Binary configs of the headless graphs, generated by data_as_c_string.
+const char kFaceMeshGraph[] =
+#include "mediapipe/library/face_mesh_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+const char kHandTrackingGraph[] =
+#include "mediapipe/library/hand_tracking_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+const char kPoseTrackingGraph[] =
+#include "mediapipe/library/pose_tracking_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+const char kHolisticTrackingGraph[] =
+#include "mediapipe/library/holistic_tracking_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+const char kFaceBlendShapeGraph[] =
+#include "mediapipe/library/face_blendshape_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+const char kFaceMeshBlendShapeGraph[] =
+#include "mediapipe/library/face_mesh_blendshape_graph.inc"
+    ;  // NOLINT(whitespace/semicolon)
+
+struct EmbeddedGraph {
+    const char* name_;
+    const char* data_;
+    size_t size_;
+};
+
+// The literals may contain NUL bytes, so their sizes come from sizeof.
+const EmbeddedGraph kEmbeddedGraphs[] = {
+    {"face_mesh", kFaceMeshGraph, sizeof(kFaceMeshGraph) - 1},
+    {"hand_tracking", kHandTrackingGraph, sizeof(kHandTrackingGraph) - 1},
+    {"pose_tracking", kPoseTrackingGraph, sizeof(kPoseTrackingGraph) - 1},
+    {"holistic_tracking", kHolisticTrackingGraph, sizeof(kHolisticTrackingGraph) - 1},
+    {"face_blendshape", kFaceBlendShapeGraph, sizeof(kFaceBlendShapeGraph) - 1},
+    {"face_mesh_blendshape", kFaceMeshBlendShapeGraph, sizeof(kFaceMeshBlendShapeGraph) - 1},
+};
+
+}  // namespace
+
+bool FindEmbeddedGraph(const std::string& name, std::string* contents) {
+    for (const auto& graph : kEmbeddedGraphs) {
+        if (name == graph.name_) {
+            contents->assign(graph.data_, graph.size_);
+            return true;
+        }
+    }
+    return false;
+}
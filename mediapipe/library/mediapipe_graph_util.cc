@@ -0,0 +1,282 @@
+#include "mediapipe_graph_util.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/tool/options_map.h"
+#include "mediapipe/framework/tool/subgraph_expansion.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace {
+
+using Node = mediapipe::CalculatorGraphConfig::Node;
+
+void RenameStream(std::string* tag_index_name, const std::string& from, const std::string& to) {
+    if (StreamName(*tag_index_name) == from) {
+        auto pos = tag_index_name->rfind(':');
+        *tag_index_name = (pos == std::string::npos ? "" : tag_index_name->substr(0, pos + 1)) + to;
+    }
+}
+
+// Normalizes "TAG" to "TAG:0" so that both spellings compare equal.
+std::string NormalizeTagIndex(const std::string& tag_index) {
+    return tag_index.find(':') == std::string::npos ? tag_index + ":0" : tag_index;
+}
+
+bool IsBackEdge(const Node& node, int input_index) {
+    const auto& stream = node.input_stream(input_index);
+    auto pos = stream.rfind(':');
+    std::string tag_index;
+    if (pos == std::string::npos) {
+        // Untagged streams are indexed by their position among untagged streams.
+        int index = 0;
+        for (int i = 0; i < input_index; ++i) {
+            if (node.input_stream(i).find(':') == std::string::npos) {
+                ++index;
+            }
+        }
+        tag_index = ":" + std::to_string(index);
+    } else {
+        tag_index = NormalizeTagIndex(stream.substr(0, pos));
+    }
+    for (const auto& info : node.input_stream_info()) {
+        if (info.back_edge() && NormalizeTagIndex(info.tag_index()) == tag_index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+absl::Status ReadGraphConfig(const std::string& graph_name, std::string* contents, bool* binary) {
+    if (absl::StartsWith(graph_name, kEmbeddedGraphPrefix)) {
+        *binary = true;
+        if (!FindEmbeddedGraph(graph_name.substr(sizeof(kEmbeddedGraphPrefix) - 1), contents)) {
+            return absl::NotFoundError("no embedded graph " + graph_name);
+        }
+        return absl::OkStatus();
+    }
+    *binary = absl::EndsWith(graph_name, ".binarypb");
+    return mediapipe::file::GetContents(graph_name, contents);
+}
+
+absl::Status ParseGraphConfig(const std::string& graph_name, const std::string& contents, bool binary,
+                              mediapipe::CalculatorGraphConfig* config) {
+    auto parsed = binary ? config->ParseFromString(contents) : mediapipe::ParseTextProto(contents, config);
+    if (!parsed) {
+        return absl::InvalidArgumentError("cannot parse graph " + graph_name);
+    }
+    return absl::OkStatus();
+}
+
+absl::Status CompileGraphConfig(const std::string& graph_name, const std::string& output_path) {
+    std::string contents;
+    bool binary = false;
+    auto status = ReadGraphConfig(graph_name, &contents, &binary);
+    if (!status.ok()) {
+        return status;
+    }
+    mediapipe::CalculatorGraphConfig config;
+    status = ParseGraphConfig(graph_name, contents, binary, &config);
+    if (!status.ok()) {
+        return status;
+    }
+    status = mediapipe::tool::ExpandSubgraphs(&config);
+    if (!status.ok()) {
+        return status;
+    }
+    return mediapipe::file::SetContents(output_path, config.SerializeAsString());
+}
+
+std::string StreamName(const std::string& tag_index_name) {
+    auto pos = tag_index_name.rfind(':');
+    return pos == std::string::npos ? tag_index_name : tag_index_name.substr(pos + 1);
+}
+
+std::set<std::string> ProducedStreams(const mediapipe::CalculatorGraphConfig& config) {
+    std::set<std::string> produced_streams;
+    for (const auto& stream : config.input_stream()) {
+        produced_streams.insert(StreamName(stream));
+    }
+    for (const auto& node : config.node()) {
+        for (const auto& stream : node.output_stream()) {
+            produced_streams.insert(StreamName(stream));
+        }
+    }
+    return produced_streams;
+}
+
+void RemoveFlowLimiters(mediapipe::CalculatorGraphConfig* config) {
+    auto* nodes = config->mutable_node();
+    for (int i = nodes->size() - 1; i >= 0; --i) {
+        const auto& limiter = nodes->Get(i);
+        if (limiter.calculator() != "FlowLimiterCalculator" || limiter.input_stream_size() == 0 || limiter.output_stream_size() == 0) {
+            continue;
+        }
+        auto input = StreamName(limiter.input_stream(0));
+        auto output = StreamName(limiter.output_stream(0));
+        nodes->DeleteSubrange(i, 1);
+        for (auto& node : *nodes) {
+            for (auto& stream : *node.mutable_input_stream()) {
+                RenameStream(&stream, output, input);
+            }
+        }
+        for (auto& stream : *config->mutable_output_stream()) {
+            RenameStream(&stream, output, input);
+        }
+    }
+}
+
+absl::Status PruneGraph(mediapipe::CalculatorGraphConfig* config, const std::vector<std::string>& output_streams) {
+    if (output_streams.empty()) {
+        return absl::OkStatus();
+    }
+    // Walks producers backwards from the observed streams. Back edges are not
+    // followed, otherwise a flow limiter would keep its renderer alive.
+    std::set<std::string> needed_streams(output_streams.begin(), output_streams.end());
+    std::set<std::string> needed_side_packets;
+    std::vector<bool> keep(config->node_size(), false);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < config->node_size(); ++i) {
+            if (keep[i]) {
+                continue;
+            }
+            const auto& node = config->node(i);
+            bool contributes = false;
+            for (const auto& stream : node.output_stream()) {
+                contributes = contributes || needed_streams.count(StreamName(stream)) > 0;
+            }
+            for (const auto& side_packet : node.output_side_packet()) {
+                contributes = contributes || needed_side_packets.count(StreamName(side_packet)) > 0;
+            }
+            if (!contributes) {
+                continue;
+            }
+            keep[i] = true;
+            changed = true;
+            for (int j = 0; j < node.input_stream_size(); ++j) {
+                if (!IsBackEdge(node, j)) {
+                    needed_streams.insert(StreamName(node.input_stream(j)));
+                }
+            }
+            for (const auto& side_packet : node.input_side_packet()) {
+                needed_side_packets.insert(StreamName(side_packet));
+            }
+        }
+    }
+
+    mediapipe::CalculatorGraphConfig pruned;
+    for (const auto& stream : config->input_stream()) {
+        *pruned.add_input_stream() = stream;
+    }
+    for (int i = 0; i < config->node_size(); ++i) {
+        if (keep[i]) {
+            *pruned.add_node() = config->node(i);
+        }
+    }
+    // A back edge whose producer was pruned is not rewired: feeding, say, a flow
+    // limiter's FINISHED from another stream would change when it admits frames.
+    auto produced_streams = ProducedStreams(pruned);
+    for (const auto& node : pruned.node()) {
+        for (int j = 0; j < node.input_stream_size(); ++j) {
+            if (IsBackEdge(node, j) && !produced_streams.count(StreamName(node.input_stream(j)))) {
+                return absl::FailedPreconditionError("pruning removes the producer of back edge " + node.input_stream(j) +
+                                                     " of " + node.calculator() + "; use a headless graph instead");
+            }
+        }
+    }
+
+    google::protobuf::RepeatedPtrField<Node> kept_nodes;
+    for (int i = 0; i < config->node_size(); ++i) {
+        if (keep[i]) {
+            kept_nodes.Add()->Swap(config->mutable_node(i));
+        }
+    }
+    config->mutable_node()->Swap(&kept_nodes);
+
+    google::protobuf::RepeatedPtrField<std::string> kept_outputs;
+    for (const auto& stream : config->output_stream()) {
+        if (produced_streams.count(StreamName(stream))) {
+            *kept_outputs.Add() = stream;
+        }
+    }
+    config->mutable_output_stream()->Swap(&kept_outputs);
+    return absl::OkStatus();
+}
+
+bool AddPacketBundle(mediapipe::CalculatorGraphConfig* config, const std::vector<std::string>& input_streams, const std::string& output_stream) {
+    auto produced_streams = ProducedStreams(*config);
+    for (const auto& stream : input_streams) {
+        if (!produced_streams.count(stream)) {
+            return false;
+        }
+    }
+    auto* node = config->add_node();
+    node->set_calculator("PacketBundleCalculator");
+    for (const auto& stream : input_streams) {
+        node->add_input_stream(stream);
+    }
+    node->add_output_stream(output_stream);
+    return true;
+}
+
+void SetDefaultExecutorOptions(mediapipe::CalculatorGraphConfig* config, const mediapipe::ThreadPoolExecutorOptions& options,
+                               const std::string& type) {
+    mediapipe::ExecutorConfig* executor = nullptr;
+    for (auto& candidate : *config->mutable_executor()) {
+        if (candidate.name().empty()) {
+            executor = &candidate;
+        }
+    }
+    if (!executor) {
+        executor = config->add_executor();
+    }
+    auto* executor_options = executor->mutable_options()->MutableExtension(mediapipe::ThreadPoolExecutorOptions::ext);
+    executor_options->MergeFrom(options);
+    if (!type.empty()) {
+        executor->set_type(type);
+        // Only the untyped default executor picks its own size.
+        if (executor_options->num_threads() <= 0) {
+            executor_options->set_num_threads(mediapipe::NumCPUCores());
+        }
+    }
+}
+
+absl::Status SetInferenceThreads(mediapipe::CalculatorGraphConfig* config, int num_threads) {
+    // The InferenceCalculator nodes live inside the module subgraphs.
+    auto status = mediapipe::tool::ExpandSubgraphs(config);
+    if (!status.ok()) {
+        return status;
+    }
+    for (auto& node : *config->mutable_node()) {
+        if (!absl::StartsWith(node.calculator(), "InferenceCalculator")) {
+            continue;
+        }
+        // Options come either as a CalculatorOptions extension or as Any.
+        auto from_extension = node.has_options();
+        mediapipe::InferenceCalculatorOptions options;
+        if (from_extension) {
+            options = node.options().GetExtension(mediapipe::InferenceCalculatorOptions::ext);
+        } else {
+            mediapipe::tool::GetNodeOptions(node, &options);
+        }
+        options.set_cpu_num_thread(num_threads);
+        if (options.delegate().has_xnnpack()) {
+            options.mutable_delegate()->mutable_xnnpack()->set_num_threads(num_threads);
+        }
+        if (from_extension) {
+            *node.mutable_options()->MutableExtension(mediapipe::InferenceCalculatorOptions::ext) = options;
+        } else {
+            mediapipe::tool::SetNodeOptions(node, options);
+        }
+    }
+    return absl::OkStatus();
+}
@@ -0,0 +1,60 @@
+#ifndef MEDIAPIPE_GRAPH_UTIL_HPP_
+#define MEDIAPIPE_GRAPH_UTIL_HPP_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+
+// Prefix of graph names that refer to a graph compiled into the library.
+constexpr char kEmbeddedGraphPrefix[] = "embedded:";
+
+// Reads graph_name, which is a text .pbtxt file, a binary .binarypb file or
+// "embedded:<name>", into contents and tells whether it is binary.
+absl::Status ReadGraphConfig(const std::string& graph_name, std::string* contents, bool* binary);
+
+// Decodes contents as read by ReadGraphConfig.
+absl::Status ParseGraphConfig(const std::string& graph_name, const std::string& contents, bool binary,
+                              mediapipe::CalculatorGraphConfig* config);
+
+// Writes graph_name to output_path as a binary config with every subgraph
+// expanded, so that loading it skips text parsing and expansion.
+absl::Status CompileGraphConfig(const std::string& graph_name, const std::string& output_path);
+
+// Looks up a binary config compiled into the library; defined in
+// mediapipe_embedded_graphs.cc.
+bool FindEmbeddedGraph(const std::string& name, std::string* contents);
+
+// Returns the stream name of a "TAG:index:name" reference.
+std::string StreamName(const std::string& tag_index_name);
+
+// Returns the graph input streams and every stream a node outputs.
+std::set<std::string> ProducedStreams(const mediapipe::CalculatorGraphConfig& config);
+
+// Drops every FlowLimiterCalculator and feeds its consumers straight from its
+// input, so no frame is ever discarded.
+void RemoveFlowLimiters(mediapipe::CalculatorGraphConfig* config);
+
+// Removes every node that does not contribute to output_streams, together with
+// the graph outputs they produced. Fails, leaving the config untouched, when a
+// kept back edge loses its producer, such as the FINISHED input of a
+// FlowLimiterCalculator fed by a renderer; such graphs need a headless variant.
+absl::Status PruneGraph(mediapipe::CalculatorGraphConfig* config, const std::vector<std::string>& output_streams);
+
+// Adds a PacketBundleCalculator that gathers input_streams into one
+// std::vector<Packet> per timestamp on output_stream. Returns false, leaving
+// the config untouched, when the graph does not produce every input stream.
+bool AddPacketBundle(mediapipe::CalculatorGraphConfig* config, const std::vector<std::string>& input_streams, const std::string& output_stream);
+
+// Merges the set fields of options into the graph's default executor config,
+// and sets its executor type unless type is empty.
+void SetDefaultExecutorOptions(mediapipe::CalculatorGraphConfig* config, const mediapipe::ThreadPoolExecutorOptions& options,
+                               const std::string& type = "");
+
+// Expands the subgraphs of config and makes every InferenceCalculator run
+// its interpreter and XNNPACK delegate on num_threads threads.
+absl::Status SetInferenceThreads(mediapipe::CalculatorGraphConfig* config, int num_threads);
+
+#endif
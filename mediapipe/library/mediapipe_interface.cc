@@ -1,20 +1,30 @@
 #include "mediapipe_interface.hpp"
+#include "mediapipe_graph_util.hpp"
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/classification.pb.h"
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/shared_executor.pb.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/work_stealing_executor.h"
+#include "mediapipe/util/cpu_util.h"
 #include "mediapipe/util/resource_util.h"
+#include <algorithm>
+#include <chrono>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -22,49 +32,539 @@
 
 ABSL_DECLARE_FLAG(std::string, resource_root_dir);
 
+namespace {
+
+// Writes at most size landmarks of list to out and returns how many were written.
+unsigned CopyLandmarks(const mediapipe::NormalizedLandmarkList& list, NormalizedLandmark* out, size_t size) {
+    auto count = std::min<size_t>(size, list.landmark_size());
+    for (size_t i = 0; i < count; ++i) {
+        const auto& landmark = list.landmark(static_cast<int>(i));
+        out[i] = {landmark.x(), landmark.y(), landmark.z(), landmark.visibility(), landmark.presence()};
+    }
+    return static_cast<unsigned>(count);
+}
+
+// Converts list into the reusable buffer, which only reallocates when a list
+// outgrows every previous one, and returns a view valid until the next call.
+NormalizedLandmark* FillLandmarkBuffer(const mediapipe::NormalizedLandmarkList& list, std::vector<NormalizedLandmark>* buffer) {
+    if (buffer->size() < static_cast<size_t>(list.landmark_size())) {
+        buffer->resize(list.landmark_size());
+    }
+    CopyLandmarks(list, buffer->data(), list.landmark_size());
+    return buffer->data();
+}
+
+// Packs count lists of one frame, with the matching handedness when given, into
+// the reusable buffer and returns a view valid until the next call.
+const MpLandmarkResult* FillLandmarkResult(mediapipe::Timestamp timestamp,
+                                           const mediapipe::NormalizedLandmarkList* lists, size_t count,
+                                           const std::vector<mediapipe::ClassificationList>* handedness,
+                                           LandmarkResultBuffer* buffer) {
+    buffer->offsets_.assign(1, 0);
+    buffer->landmarks_.clear();
+    buffer->handedness_.clear();
+    buffer->scores_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const auto& list = lists[i];
+        auto offset = buffer->landmarks_.size();
+        buffer->landmarks_.resize(offset + list.landmark_size());
+        CopyLandmarks(list, buffer->landmarks_.data() + offset, list.landmark_size());
+        buffer->offsets_.push_back(static_cast<unsigned>(buffer->landmarks_.size()));
+        int hand = HANDEDNESS_NONE;
+        float score = 0.f;
+        if (handedness && i < handedness->size() && (*handedness)[i].classification_size() > 0) {
+            const auto& classification = (*handedness)[i].classification(0);
+            hand = classification.label() == "Left" ? HANDEDNESS_LEFT : HANDEDNESS_RIGHT;
+            score = classification.score();
+        }
+        buffer->handedness_.push_back(hand);
+        buffer->scores_.push_back(score);
+    }
+    buffer->result_ = {timestamp.Value(), static_cast<unsigned>(count), buffer->offsets_.data(),
+                       buffer->landmarks_.data(), buffer->handedness_.data(), buffer->scores_.data()};
+    return &buffer->result_;
+}
+
+const MpLandmarkResult* FillLandmarkResult(mediapipe::Timestamp timestamp,
+                                           const std::vector<mediapipe::NormalizedLandmarkList>* lists,
+                                           const std::vector<mediapipe::ClassificationList>* handedness,
+                                           LandmarkResultBuffer* buffer) {
+    return FillLandmarkResult(timestamp, lists ? lists->data() : nullptr, lists ? lists->size() : 0, handedness, buffer);
+}
+
+// Packs the landmarks of every list into out, up to size, and returns how
+// many were written.
+int CopyLandmarkLists(const std::vector<mediapipe::NormalizedLandmarkList>& lists, NormalizedLandmark* out, size_t size) {
+    size_t written = 0;
+    for (const auto& list : lists) {
+        written += CopyLandmarks(list, out + written, size - written);
+    }
+    return static_cast<int>(written);
+}
+
+// Writes at most size blendshape scores to out and returns how many were written.
+unsigned CopyBlendShapes(const mediapipe::ClassificationList& blend_shapes, float* out, size_t size) {
+    auto count = std::min<size_t>(size, blend_shapes.classification_size());
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = blend_shapes.classification(static_cast<int>(i)).score();
+    }
+    return static_cast<unsigned>(count);
+}
+
+// Floats per landmark in a landmark trace slot.
+constexpr unsigned kLandmarkValues = sizeof(NormalizedLandmark) / sizeof(float);
+
+// Writes at most capacity landmarks of list to a landmark trace slot.
+void RecordLandmarks(const mediapipe::NormalizedLandmarkList& list, float* slot, size_t capacity) {
+    CopyLandmarks(list, reinterpret_cast<NormalizedLandmark*>(slot), capacity);
+}
+
+void ReserveLandmarkResult(LandmarkResultBuffer* buffer, size_t instances, size_t landmarks_per_instance) {
+    buffer->offsets_.reserve(instances + 1);
+    buffer->landmarks_.reserve(instances * landmarks_per_instance);
+    buffer->handedness_.reserve(instances);
+    buffer->scores_.reserve(instances);
+}
+
+// Returns the microseconds since *start and restarts it.
+long long ElapsedUs(std::chrono::steady_clock::time_point* start) {
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - *start).count();
+    *start = now;
+    return elapsed;
+}
+
+// Returns the work-stealing executor shared by every handle created with
+// shared_executor_ and work_stealing_, creating it from options when no handle
+// holds it any more.
+std::shared_ptr<mediapipe::Executor> AcquireWorkStealingExecutor(mediapipe::ThreadPoolExecutorOptions options) {
+    static std::mutex shared_executor_mutex;
+    static std::weak_ptr<mediapipe::Executor> shared_executor;
+    std::lock_guard<std::mutex> lock(shared_executor_mutex);
+    auto executor = shared_executor.lock();
+    if (executor) {
+        return executor;
+    }
+    if (!options.has_num_threads()) {
+        options.set_num_threads(mediapipe::NumCPUCores());
+    }
+    mediapipe::MediaPipeOptions extendable_options;
+    *extendable_options.MutableExtension(mediapipe::ThreadPoolExecutorOptions::ext) = options;
+    auto executor_or_status = mediapipe::WorkStealingExecutor::Create(extendable_options);
+    if (!executor_or_status.ok()) {
+        std::cout << executor_or_status.status().ToString() << std::endl ;
+        throw StatusError(executor_or_status.status());
+    }
+    executor.reset(executor_or_status.value());
+    shared_executor = executor;
+    return executor;
+}
+
+// Returns a new executor of its own on the worker pool shared by every handle
+// created with shared_executor_. The first of them sizes the pool from options.
+std::shared_ptr<mediapipe::SharedExecutor> CreateSharedExecutor(const mediapipe::ThreadPoolExecutorOptions& options,
+                                                                int weight) {
+    mediapipe::MediaPipeOptions extendable_options;
+    *extendable_options.MutableExtension(mediapipe::ThreadPoolExecutorOptions::ext) = options;
+    auto* shared_options = extendable_options.MutableExtension(mediapipe::SharedExecutorOptions::ext);
+    shared_options->set_pool_name("mediapipe_library");
+    if (weight > 0) {
+        shared_options->set_weight(weight);
+    }
+    auto executor_or_status = mediapipe::SharedExecutor::Create(extendable_options);
+    if (!executor_or_status.ok()) {
+        std::cout << executor_or_status.status().ToString() << std::endl ;
+        throw StatusError(executor_or_status.status());
+    }
+    return std::shared_ptr<mediapipe::SharedExecutor>(
+        static_cast<mediapipe::SharedExecutor*>(executor_or_status.value()));
+}
+
+// Returns the ImageFrame format that RGB and BGR layouts of image enter the
+// graph with; YUV layouts are converted to SRGB.
+mediapipe::ImageFormat::Format ImageFrameFormat(MpImageFormat format) {
+    switch (format) {
+        case IMAGE_SRGB:
+        case IMAGE_NV12:
+        case IMAGE_I420:
+            return mediapipe::ImageFormat::SRGB;
+        case IMAGE_SRGBA:
+            return mediapipe::ImageFormat::SRGBA;
+        case IMAGE_BGR:
+            return mediapipe::ImageFormat::SBGR;
+        case IMAGE_BGRA:
+            return mediapipe::ImageFormat::SBGRA;
+    }
+    throw std::invalid_argument("unknown MpImageFormat");
+}
+
+// Throws std::invalid_argument unless image describes a frame that can be read
+// without going past its rows.
+void ValidateImage(const MpImage& image) {
+    auto yuv = image.format_ == IMAGE_NV12 || image.format_ == IMAGE_I420;
+    // Also rejects an unknown format.
+    auto channels = yuv ? 1 : mediapipe::ImageFrame::NumberOfChannelsForFormat(ImageFrameFormat(image.format_));
+    if (!image.data_) {
+        throw std::invalid_argument("null MpImage data");
+    }
+    if (image.width_ <= 0 || image.height_ <= 0) {
+        throw std::invalid_argument("MpImage width and height must be positive");
+    }
+    if (yuv && (image.width_ % 2 != 0 || image.height_ % 2 != 0)) {
+        throw std::invalid_argument("NV12 and I420 MpImage width and height must be even");
+    }
+    if (image.width_step_ != 0 && image.width_step_ < image.width_ * channels) {
+        throw std::invalid_argument("MpImage width_step is shorter than a row");
+    }
+}
+
+}  // namespace
+
 MediapipeInterface::MediapipeInterface() {
-    absl::SetFlag(&FLAGS_resource_root_dir, "");
-    
+    // The flag is process-wide, so handles created concurrently must not race on it.
+    static std::once_flag resource_root_dir_flag;
+    std::call_once(resource_root_dir_flag, [] { absl::SetFlag(&FLAGS_resource_root_dir, ""); });
 }
 
-void MediapipeInterface::SetGraph(const std::string& graph_name) {
+void MediapipeInterface::SetGraph(const std::string& graph_name, const MpOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (options.input_stream_) {
+        input_stream_ = options.input_stream_;
+    }
+    if (options.frame_pool_size_ > 0) {
+        frame_pool_size_ = options.frame_pool_size_;
+    }
+    auto offline = options.offline_ != 0;
+    auto drop_policy = options.drop_policy_;
+    if (drop_policy != MP_DROP_OLDEST && drop_policy != MP_DROP_NEWEST && drop_policy != MP_BLOCK) {
+        throw std::invalid_argument("unknown MpDropPolicy");
+    }
+    submit_queue_ = std::make_shared<SubmitQueue>(std::max(options.submit_queue_size_, 0), drop_policy,
+                                                  options.max_in_flight_ > 0 ? options.max_in_flight_ : 2);
+    if (options.warmup_frames_ > 0) {
+        warmup_frames_ = options.warmup_frames_;
+    }
+    if (options.warmup_width_ > 0 && options.warmup_height_ > 0) {
+        warmup_width_ = options.warmup_width_;
+        warmup_height_ = options.warmup_height_;
+    }
+    auto phase_start = std::chrono::steady_clock::now();
     std::string graph_content;
-    auto status = mediapipe::file::GetContents(graph_name, &graph_content);
+    bool binary = false;
+    auto status = ReadGraphConfig(graph_name, &graph_content, &binary);
     if(!status.ok()){
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
     }
-    auto config = mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(graph_content);
+    startup_.load_us_ = ElapsedUs(&phase_start);
+    mediapipe::CalculatorGraphConfig config;
+    status = ParseGraphConfig(graph_name, graph_content, binary, &config);
+    if (!status.ok()) {
+        std::cout << status.ToString() << std::endl ;
+        throw StatusError(status);
+    }
+    startup_.parse_us_ = ElapsedUs(&phase_start);
+    if (options.inference_threads_ > 0) {
+        status = SetInferenceThreads(&config, options.inference_threads_);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    mediapipe::ThreadPoolExecutorOptions executor_options;
+    if (options.num_threads_ > 0) {
+        executor_options.set_num_threads(options.num_threads_);
+    }
+    if (options.nice_priority_level_ != 0) {
+        executor_options.set_nice_priority_level(options.nice_priority_level_);
+    }
+    if (options.thread_name_prefix_) {
+        executor_options.set_thread_name_prefix(options.thread_name_prefix_);
+    }
+    if (options.shared_executor_ && options.work_stealing_) {
+        // A default executor handed to the graph overrides the one in config.
+        status = graph_.SetExecutor("", AcquireWorkStealingExecutor(executor_options));
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    } else if (options.shared_executor_) {
+        shared_executor_ = CreateSharedExecutor(executor_options, options.executor_weight_);
+        status = graph_.SetExecutor("", shared_executor_);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    } else if (options.work_stealing_) {
+        SetDefaultExecutorOptions(&config, executor_options, "WorkStealingExecutor");
+    } else if (executor_options.ByteSizeLong() > 0) {
+        SetDefaultExecutorOptions(&config, executor_options);
+    }
+    if (options.enable_profiler_) {
+        // Only per-calculator Process times are kept; tracing stays off.
+        config.mutable_profiler_config()->set_enable_profiler(true);
+    }
+    if (offline) {
+        // Every frame is kept; bounded queues make Process block instead.
+        RemoveFlowLimiters(&config);
+        config.set_max_queue_size(options.max_queue_size_ > 0 ? options.max_queue_size_ : 16);
+    }
+    // After RemoveFlowLimiters, which leaves offline graphs without back edges
+    // that pruning could orphan.
+    if (options.prune_outputs_) {
+        status = PruneGraph(&config, OutputStreams());
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    auto result_streams = ResultStreams();
+    // Graphs lacking any of these streams just offer no result stream.
+    has_result_stream_ = !result_streams.empty() && AddPacketBundle(&config, result_streams, RESULT_STREAM_);
+    phase_start = std::chrono::steady_clock::now();
     status = graph_.Initialize(config);
     if (!status.ok()) {
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
+    }
+    startup_.initialize_us_ = ElapsedUs(&phase_start);
+    stats_.SetStartupTimings(startup_);
+    if (offline) {
+        graph_.SetGraphInputStreamAddMode(mediapipe::CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+    }
+    auto timing_stream = OutputStreams()[0];
+    if (ProducedStreams(config).count(timing_stream)) {
+        auto timing_callback = [this](const mediapipe::Packet& packet) {
+            stats_.OnOutput(packet.Timestamp().Value());
+            return absl::OkStatus();
+        };
+        status = graph_.ObserveOutputStream(timing_stream, timing_callback, true);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    auto latest_stream = LatestStream();
+    if (!latest_stream.empty() && (latest_stream != RESULT_STREAM_ || has_result_stream_)) {
+        // Bounds are observed too, so a frame without detections replaces a stale result.
+        auto latest_callback = [this](const mediapipe::Packet& packet) {
+            if (IsWarmup(packet)) {
+                return absl::OkStatus();
+            }
+            {
+                std::lock_guard<std::mutex> latest_lock(latest_mutex_);
+                latest_packet_ = packet;
+                latest_fresh_ = true;
+            }
+            latest_ready_.notify_all();
+            return absl::OkStatus();
+        };
+        status = graph_.ObserveOutputStream(latest_stream, latest_callback, true);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+}
+
+bool MediapipeInterface::TakeLatest(int64_t timeout_us, mediapipe::Packet* packet) {
+    std::unique_lock<std::mutex> latest_lock(latest_mutex_);
+    if (!latest_ready_.wait_for(latest_lock, std::chrono::microseconds(std::max<int64_t>(timeout_us, 0)), [this] { return latest_fresh_; })) {
+        return false;
+    }
+    *packet = std::move(latest_packet_);
+    latest_packet_ = mediapipe::Packet();
+    latest_fresh_ = false;
+    return true;
+}
+
+MediapipeInterface::~MediapipeInterface() {
+    // The worker feeds graph_, so it must be gone before the graph is.
+    if (submit_queue_) {
+        submit_queue_->Stop();
     }
 }
 
 void MediapipeInterface::Start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto phase_start = std::chrono::steady_clock::now();
     auto status = graph_.StartRun({});
     if (!status.ok()) {
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
+    }
+    startup_.start_us_ = ElapsedUs(&phase_start);
+    Warmup();
+    startup_.warmup_us_ = ElapsedUs(&phase_start);
+    stats_.SetStartupTimings(startup_);
+    submit_queue_->Start([this](mediapipe::Packet packet) { return graph_.AddPacketToInputStream(input_stream_, std::move(packet)); });
+}
+
+void MediapipeInterface::Warmup() {
+    for (int i = 0; i < warmup_frames_; ++i) {
+        auto frame = absl::make_unique<mediapipe::ImageFrame>(mediapipe::ImageFormat::SRGB, warmup_width_, warmup_height_,
+                                                              mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+        frame->SetToZero();
+        auto status = graph_.AddPacketToInputStream(
+            input_stream_, mediapipe::Adopt(frame.release()).At(mediapipe::Timestamp(i - warmup_frames_)));
+        if (status.ok()) {
+            // One frame at a time, so that no flow limiter drops any of them.
+            status = graph_.WaitUntilIdle();
+        }
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
     }
 }
 
-void MediapipeInterface::Process(const cv::Mat& input) {
-    auto input_frame = absl::make_unique<mediapipe::ImageFrame>(mediapipe::ImageFormat::SRGB, input.cols, input.rows, mediapipe::ImageFrame::kDefaultAlignmentBoundary);
-    auto input_frame_mat = mediapipe::formats::MatView(input_frame.get());
+absl::Status MediapipeInterface::ObserveResults(const std::string& stream, std::function<absl::Status(const mediapipe::Packet&)> callback,
+                                                bool observe_timestamp_bounds) {
+    return graph_.ObserveOutputStream(
+        stream,
+        [callback = std::move(callback)](const mediapipe::Packet& packet) {
+            return IsWarmup(packet) ? absl::OkStatus() : callback(packet);
+        },
+        observe_timestamp_bounds);
+}
+
+bool MediapipeInterface::NextResult(mediapipe::OutputStreamPoller* poller, mediapipe::Packet* packet) {
+    while (poller->Next(packet)) {
+        if (!IsWarmup(*packet)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MediapipeInterface::Process(const cv::Mat& input) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto pooled_frame = GetPooledFrame(input.cols, input.rows, mediapipe::ImageFormat::SRGB);
+    auto input_frame_mat = mediapipe::formats::MatView(pooled_frame.get());
     input.copyTo(input_frame_mat);
-    size_t frameTimestampUs = static_cast<double>(cv::getTickCount()) / static_cast<double>(cv::getTickFrequency()) * 1e6;
-    auto status = graph_.AddPacketToInputStream(INPUT_STREAM_, mediapipe::Adopt(input_frame.release()).At(mediapipe::Timestamp(frameTimestampUs)));
+    return AddFrame(BorrowPooledFrame(pooled_frame));
+}
+
+bool MediapipeInterface::Process(const MpImage& image, frame_release_callback release, void* user_data, int64_t timestamp_us) {
+    ValidateImage(image);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (image.format_ == IMAGE_NV12 || image.format_ == IMAGE_I420) {
+        // YUV has no ImageFrame format, so it is converted in the one pass
+        // that would otherwise copy the frame.
+        auto pooled_frame = GetPooledFrame(image.width_, image.height_, mediapipe::ImageFormat::SRGB);
+        auto width_step = image.width_step_ ? image.width_step_ : image.width_;
+        cv::Mat yuv(image.height_ * 3 / 2, image.width_, CV_8UC1, image.data_, width_step);
+        auto input_frame_mat = mediapipe::formats::MatView(pooled_frame.get());
+        cv::cvtColor(yuv, input_frame_mat, image.format_ == IMAGE_NV12 ? cv::COLOR_YUV2RGB_NV12 : cv::COLOR_YUV2RGB_I420);
+        if (release) {
+            release(image.data_, user_data);
+        }
+        return AddFrame(BorrowPooledFrame(pooled_frame), timestamp_us);
+    }
+    // RGB and BGR layouts enter the graph untouched; the channel order is
+    // resolved on the model-sized crop inside ImageToTensorCalculator.
+    auto format = ImageFrameFormat(image.format_);
+    auto width_step = image.width_step_ ? image.width_step_ : image.width_ * mediapipe::ImageFrame::NumberOfChannelsForFormat(format);
+    if (!release) {
+        auto pooled_frame = GetPooledFrame(image.width_, image.height_, format);
+        mediapipe::ImageFrame caller_frame(format, image.width_, image.height_, width_step, image.data_, [](uint8_t*) {});
+        auto input_frame_mat = mediapipe::formats::MatView(pooled_frame.get());
+        mediapipe::formats::MatView(&caller_frame).copyTo(input_frame_mat);
+        return AddFrame(BorrowPooledFrame(pooled_frame), timestamp_us);
+    }
+    auto input_frame = absl::make_unique<mediapipe::ImageFrame>(
+        format, image.width_, image.height_, width_step, image.data_,
+        [release, user_data](uint8_t* data) { release(data, user_data); });
+    return AddFrame(std::move(input_frame), timestamp_us);
+}
+
+std::shared_ptr<mediapipe::ImageFrame> MediapipeInterface::GetPooledFrame(int width, int height, mediapipe::ImageFormat::Format format) {
+    if (!frame_pool_ || frame_pool_->width() != width || frame_pool_->height() != height || frame_pool_->format() != format) {
+        frame_pool_ = mediapipe::ImageFramePool::Create(width, height, format, frame_pool_size_);
+    }
+    return frame_pool_->GetBuffer();
+}
+
+std::unique_ptr<mediapipe::ImageFrame> MediapipeInterface::BorrowPooledFrame(const std::shared_ptr<mediapipe::ImageFrame>& pooled_frame) {
+    // The packet borrows the pooled pixels; the buffer returns to the pool once the graph drops it.
+    return absl::make_unique<mediapipe::ImageFrame>(
+        pooled_frame->Format(), pooled_frame->Width(), pooled_frame->Height(), pooled_frame->WidthStep(),
+        pooled_frame->MutablePixelData(), [pooled_frame](uint8_t*) {});
+}
+
+bool MediapipeInterface::AddFrame(std::unique_ptr<mediapipe::ImageFrame> input_frame, int64_t timestamp_us) {
+    int64_t frameTimestampUs = timestamp_us;
+    if (frameTimestampUs < 0) {
+        frameTimestampUs = static_cast<double>(cv::getTickCount()) / static_cast<double>(cv::getTickFrequency()) * 1e6;
+        // Two frames submitted within the same microsecond would otherwise share a timestamp.
+        frameTimestampUs = std::max(frameTimestampUs, last_timestamp_us_ + 1);
+    }
+    last_timestamp_us_ = frameTimestampUs;
+    // Recorded first, as a synchronous submission may deliver the result
+    // before Push returns.
+    stats_.OnInput(frameTimestampUs);
+    auto accepted = submit_queue_->Push(std::move(input_frame), mediapipe::Timestamp(frameTimestampUs));
+    if (!accepted.ok()) {
+        std::cout << accepted.status().ToString() << std::endl ;
+        throw StatusError(accepted.status());
+    }
+    return *accepted;
+}
+
+void MediapipeInterface::Record(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto channels = TraceChannels();
+    if (channels.empty() || !has_result_stream_) {
+        auto status = absl::FailedPreconditionError("the graph offers no results to record");
+        std::cout << status.ToString() << std::endl ;
+        throw StatusError(status);
+    }
+    auto writer = std::make_unique<TraceWriter>(std::move(channels));
+    auto status = writer->Open(path);
+    if (status.ok()) {
+        auto record_callback = [this, writer = writer.get()](const mediapipe::Packet& packet) {
+            writer->BeginFrame(packet.Timestamp().Value());
+            RecordResult(packet.Get<std::vector<mediapipe::Packet>>(), writer);
+            return writer->EndFrame();
+        };
+        status = ObserveResults(RESULT_STREAM_, record_callback);
+    }
     if (!status.ok()) {
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
     }
+    trace_writer_ = std::move(writer);
 }
 
 void MediapipeInterface::Stop() {
-    static_cast<void>(graph_.CloseInputStream(INPUT_STREAM_));
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Queued frames still reach the graph before its input closes.
+    submit_queue_->Stop();
+    static_cast<void>(graph_.CloseInputStream(input_stream_));
     static_cast<void>(graph_.WaitUntilDone());
+    if (trace_writer_) {
+        // Every result has been recorded once the graph is done.
+        auto status = trace_writer_->Close();
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+}
+
+MpQueueStats MediapipeInterface::QueueStats() const {
+    return submit_queue_->Stats();
+}
+
+MpStats MediapipeInterface::Stats() {
+    MpStats stats{};
+    stats_.Fill(&stats);
+    stats.flow_limiter_dropped_ = FlowLimiterDroppedFrames(&graph_);
+    FillCalculatorStats(&graph_, &stats);
+    if (shared_executor_) {
+        stats.executor_cpu_us_ = absl::ToInt64Microseconds(shared_executor_->cpu_time());
+    }
+    return stats;
 }
 
 void MediapipeInterface::SetPreviewCallback(const MatCallback& callback) {
@@ -78,327 +578,568 @@ void MediapipeInterface::Preview() {
         preview_callback_(output_mat);
         return absl::OkStatus();
     };
-    auto status = graph_.ObserveOutputStream(OUTPUT_STREAM_, mat_callback);
+    auto status = ObserveResults(OUTPUT_STREAM_, mat_callback);
     if (!status.ok()) {
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
     }
 }
 
-void FaceMeshInterface::SetObserveCallback(const landmark_callback& callback) {
+std::vector<std::string> FaceMeshInterface::OutputStreams() const {
+    return {"multi_landmarks_presence", "multi_face_landmarks"};
+}
+
+std::string FaceMeshInterface::LatestStream() const {
+    return RESULT_STREAM_;
+}
+
+void FaceMeshInterface::SetObserveCallback(const landmark_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
     observe_callback_ = callback;
+    observe_user_data_ = user_data;
+}
+
+std::vector<std::string> FaceMeshInterface::ResultStreams() const {
+    return {"multi_face_landmarks"};
+}
+
+std::vector<TraceChannel> FaceMeshInterface::TraceChannels() const {
+    return {{"face_landmarks", TRACE_LANDMARKS, 1, kFaceLandmarkCount * kLandmarkValues}};
+}
+
+void FaceMeshInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    if (bundle[0].IsEmpty()) {
+        return;
+    }
+    auto& multi_face_landmarks = bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+    if (!multi_face_landmarks.empty()) {
+        RecordLandmarks(multi_face_landmarks[0], writer->Slot(0, 0), kFaceLandmarkCount);
+    }
+}
+
+void FaceMeshInterface::SetResultCallback(const landmark_result_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_callback_ = callback;
+    result_user_data_ = user_data;
 }
 
 void FaceMeshInterface::Observe() {
-    auto packet_callback = [&](const mediapipe::Packet& packet) {
-        auto& multi_face_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
-        for (const auto& face_landmarks : multi_face_landmarks) {
-            auto normalized_landmark_list = new NormalizedLandmark[face_landmarks.landmark_size()];
-            for(int i = 0; i< face_landmarks.landmark_size(); ++i) {
-                const auto& face_landmark = face_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = face_landmark.x();
-                normalized_landmark_list[i].y_ = face_landmark.y();
-                normalized_landmark_list[i].z_ = face_landmark.z();
-                normalized_landmark_list[i].visibility_ = face_landmark.visibility();
-                normalized_landmark_list[i].presence_ = face_landmark.presence();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (observe_callback_) {
+        landmark_buffer_.reserve(kFaceLandmarkCount);
+        auto packet_callback = [callback = observe_callback_, user_data = observe_user_data_, buffer = &landmark_buffer_](const mediapipe::Packet& packet) {
+            auto& multi_face_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+            for (const auto& face_landmarks : multi_face_landmarks) {
+                callback(FillLandmarkBuffer(face_landmarks, buffer), face_landmarks.landmark_size(), user_data);
+                return absl::OkStatus();
             }
-            observe_callback_(normalized_landmark_list, face_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
             return absl::OkStatus();
+        };
+        auto status = ObserveResults("multi_face_landmarks", packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    if (result_callback_) {
+        ReserveLandmarkResult(&result_buffer_, 2, kFaceLandmarkCount);
+        auto packet_callback = [callback = result_callback_, user_data = result_user_data_, buffer = &result_buffer_](const mediapipe::Packet& packet) {
+            auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+            const auto* multi_face_landmarks = bundle[0].IsEmpty() ? nullptr : &bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+            callback(FillLandmarkResult(packet.Timestamp(), multi_face_landmarks, nullptr, buffer), user_data);
+            return absl::OkStatus();
+        };
+        auto status = ObserveResults(RESULT_STREAM_, packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
         }
-        return absl::OkStatus();
-    };
-    auto status = graph_.ObserveOutputStream("multi_face_landmarks", packet_callback);
-    if (!status.ok()) {
-        std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
     }
 }
 
 void FaceMeshInterface::AddOutputStreamPoller() {
-    auto landmark_poller_or_status =  graph_.AddOutputStreamPoller("multi_face_landmarks");
-    auto presence_poller_or_status =  graph_.AddOutputStreamPoller("multi_landmarks_presence");
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto landmark_poller_or_status = graph_.AddOutputStreamPoller("multi_face_landmarks");
+    if (!landmark_poller_or_status.ok()) {
+        std::cout << landmark_poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(landmark_poller_or_status.status());
+    }
+    auto presence_poller_or_status = graph_.AddOutputStreamPoller("multi_landmarks_presence");
+    if (!presence_poller_or_status.ok()) {
+        std::cout << presence_poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(presence_poller_or_status.status());
+    }
     landmark_poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(landmark_poller_or_status.value()));
     presence_poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(presence_poller_or_status.value()));
 }
 
 void FaceMeshInterface::GetOutput(NormalizedLandmark * normalized_landmark_list, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
     mediapipe::Packet packet;
-    if (presence_poller_ && presence_poller_->Next(&packet)) {
+    if (presence_poller_ && NextResult(presence_poller_.get(), &packet)) {
         auto have_landmark = packet.Get<bool>();
         if (have_landmark) {
-            if(landmark_poller_ && landmark_poller_->Next(&packet)) {
+            if(landmark_poller_ && NextResult(landmark_poller_.get(), &packet)) {
                 auto& multi_face_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
                 // only one
-                for (const auto& face_landmarks : multi_face_landmarks) {
-                    assert(size == face_landmarks.landmark_size());
-                    for(int i = 0; i < size; ++i) {
-                        const auto& face_landmark = face_landmarks.landmark(i);
-                        normalized_landmark_list[i].x_ = face_landmark.x();
-                        normalized_landmark_list[i].y_ = face_landmark.y();
-                        normalized_landmark_list[i].z_ = face_landmark.z();
-                        normalized_landmark_list[i].visibility_ = face_landmark.visibility();
-                        normalized_landmark_list[i].presence_ = face_landmark.presence();
-                    }
+                if (!multi_face_landmarks.empty()) {
+                    CopyLandmarks(multi_face_landmarks[0], normalized_landmark_list, size);
                 }
             }
         }
     }
 }
 
-void HandTrackInterface::SetObserveCallback(const landmark_callback& callback) {
+int FaceMeshInterface::TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us) {
+    mediapipe::Packet packet;
+    if (!TakeLatest(timeout_us, &packet)) {
+        return -1;
+    }
+    if (timestamp_us) {
+        *timestamp_us = packet.Timestamp().Value();
+    }
+    auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+    if (bundle[0].IsEmpty()) {
+        return 0;
+    }
+    return CopyLandmarkLists(bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>(), normalized_landmark_list, size);
+}
+
+std::vector<std::string> HandTrackInterface::OutputStreams() const {
+    return {"landmarks", "handedness"};
+}
+
+std::string HandTrackInterface::LatestStream() const {
+    return RESULT_STREAM_;
+}
+
+void HandTrackInterface::SetObserveCallback(const landmark_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
     observe_callback_ = callback;
+    observe_user_data_ = user_data;
+}
+
+std::vector<std::string> HandTrackInterface::ResultStreams() const {
+    return {"landmarks", "handedness"};
+}
+
+std::vector<TraceChannel> HandTrackInterface::TraceChannels() const {
+    // Handedness slots hold the MpHandedness and its score.
+    return {{"hand_landmarks", TRACE_LANDMARKS, 2, kHandLandmarkCount * kLandmarkValues},
+            {"handedness", TRACE_SCORES, 2, 2}};
+}
+
+void HandTrackInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    if (bundle[0].IsEmpty()) {
+        return;
+    }
+    auto& multi_hand_landmarks = bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+    const auto* multi_handedness = bundle[1].IsEmpty() ? nullptr : &bundle[1].Get<std::vector<mediapipe::ClassificationList>>();
+    for (unsigned i = 0; i < std::min<size_t>(multi_hand_landmarks.size(), 2); ++i) {
+        RecordLandmarks(multi_hand_landmarks[i], writer->Slot(0, i), kHandLandmarkCount);
+        if (multi_handedness && i < multi_handedness->size() && (*multi_handedness)[i].classification_size() > 0) {
+            const auto& classification = (*multi_handedness)[i].classification(0);
+            auto* slot = writer->Slot(1, i);
+            slot[0] = classification.label() == "Left" ? HANDEDNESS_LEFT : HANDEDNESS_RIGHT;
+            slot[1] = classification.score();
+        }
+    }
+}
+
+void HandTrackInterface::SetResultCallback(const landmark_result_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_callback_ = callback;
+    result_user_data_ = user_data;
 }
 
 void HandTrackInterface::Observe() {
-    auto packet_callback = [&](const mediapipe::Packet& packet) {
-        auto& multi_hand_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
-        for (const auto& hand_landmarks : multi_hand_landmarks) {
-            auto normalized_landmark_list = new NormalizedLandmark[hand_landmarks.landmark_size()];
-            for(int i = 0; i< hand_landmarks.landmark_size(); ++i) {
-                const auto& hand_landmark = hand_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = hand_landmark.x();
-                normalized_landmark_list[i].y_ = hand_landmark.y();
-                normalized_landmark_list[i].z_ = hand_landmark.z();
-                normalized_landmark_list[i].visibility_ = hand_landmark.visibility();
-                normalized_landmark_list[i].presence_ = hand_landmark.presence();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (observe_callback_) {
+        landmark_buffer_.reserve(kHandLandmarkCount);
+        auto packet_callback = [callback = observe_callback_, user_data = observe_user_data_, buffer = &landmark_buffer_](const mediapipe::Packet& packet) {
+            auto& multi_hand_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+            for (const auto& hand_landmarks : multi_hand_landmarks) {
+                callback(FillLandmarkBuffer(hand_landmarks, buffer), hand_landmarks.landmark_size(), user_data);
+                return absl::OkStatus();
             }
-            observe_callback_(normalized_landmark_list, hand_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
             return absl::OkStatus();
+        };
+        auto status = ObserveResults("landmarks", packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    if (result_callback_) {
+        ReserveLandmarkResult(&result_buffer_, 2, kHandLandmarkCount);
+        auto packet_callback = [callback = result_callback_, user_data = result_user_data_, buffer = &result_buffer_](const mediapipe::Packet& packet) {
+            auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+            const auto* multi_hand_landmarks = bundle[0].IsEmpty() ? nullptr : &bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+            const auto* multi_handedness = bundle[1].IsEmpty() ? nullptr : &bundle[1].Get<std::vector<mediapipe::ClassificationList>>();
+            callback(FillLandmarkResult(packet.Timestamp(), multi_hand_landmarks, multi_handedness, buffer), user_data);
+            return absl::OkStatus();
+        };
+        auto status = ObserveResults(RESULT_STREAM_, packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
         }
-        return absl::OkStatus();
-    };
-    auto status = graph_.ObserveOutputStream("landmarks", packet_callback);
-    if (!status.ok()) {
-        std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
     }
 }
 
 void HandTrackInterface::AddOutputStreamPoller() {
-    auto poller_or_status =  graph_.AddOutputStreamPoller("landmarks");
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto poller_or_status = graph_.AddOutputStreamPoller("landmarks");
+    if (!poller_or_status.ok()) {
+        std::cout << poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(poller_or_status.status());
+    }
     poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(poller_or_status.value()));
 }
 
 void HandTrackInterface::GetOutput(NormalizedLandmark * normalized_landmark_list, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
     mediapipe::Packet packet;
-    if(poller_ && poller_->Next(&packet)) {
-        auto& multi_face_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+    if(poller_ && NextResult(poller_.get(), &packet)) {
+        auto& multi_hand_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
         // only one
-        for (const auto& face_landmarks : multi_face_landmarks) {
-            assert(size = face_landmarks.landmark_size());
-            for(int i = 0; i < size; ++i) {
-                const auto& face_landmark = face_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = face_landmark.x();
-                normalized_landmark_list[i].y_ = face_landmark.y();
-                normalized_landmark_list[i].z_ = face_landmark.z();
-                normalized_landmark_list[i].visibility_ = face_landmark.visibility();
-                normalized_landmark_list[i].presence_ = face_landmark.presence();
-            }
+        if (!multi_hand_landmarks.empty()) {
+            CopyLandmarks(multi_hand_landmarks[0], normalized_landmark_list, size);
         }
     }
 }
 
-void PoseTrackInterface::SetObserveCallback(const landmark_callback& callback) {
+int HandTrackInterface::TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us) {
+    mediapipe::Packet packet;
+    if (!TakeLatest(timeout_us, &packet)) {
+        return -1;
+    }
+    if (timestamp_us) {
+        *timestamp_us = packet.Timestamp().Value();
+    }
+    auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+    if (bundle[0].IsEmpty()) {
+        return 0;
+    }
+    return CopyLandmarkLists(bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>(), normalized_landmark_list, size);
+}
+
+std::vector<std::string> PoseTrackInterface::OutputStreams() const {
+    return {"pose_landmarks"};
+}
+
+std::string PoseTrackInterface::LatestStream() const {
+    return "pose_landmarks";
+}
+
+std::vector<std::string> PoseTrackInterface::ResultStreams() const {
+    return {"pose_landmarks"};
+}
+
+std::vector<TraceChannel> PoseTrackInterface::TraceChannels() const {
+    return {{"pose_landmarks", TRACE_LANDMARKS, 1, kPoseLandmarkCount * kLandmarkValues}};
+}
+
+void PoseTrackInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    if (!bundle[0].IsEmpty()) {
+        RecordLandmarks(bundle[0].Get<mediapipe::NormalizedLandmarkList>(), writer->Slot(0, 0), kPoseLandmarkCount);
+    }
+}
+
+void PoseTrackInterface::SetObserveCallback(const landmark_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
     observe_callback_ = callback;
+    observe_user_data_ = user_data;
+}
+
+void PoseTrackInterface::SetResultCallback(const landmark_result_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_callback_ = callback;
+    result_user_data_ = user_data;
 }
 
 void PoseTrackInterface::Observe() {
-    auto packet_callback = [&](const mediapipe::Packet& packet) {
-        auto& pose_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
-        auto normalized_landmark_list = new NormalizedLandmark[pose_landmarks.landmark_size()];
-        for(int i = 0; i< pose_landmarks.landmark_size(); ++i) {
-            const auto& pose_landmark = pose_landmarks.landmark(i);
-            normalized_landmark_list[i].x_ = pose_landmark.x();
-            normalized_landmark_list[i].y_ = pose_landmark.y();
-            normalized_landmark_list[i].z_ = pose_landmark.z();
-            normalized_landmark_list[i].visibility_ = pose_landmark.visibility();
-            normalized_landmark_list[i].presence_ = pose_landmark.presence();
-        }
-        observe_callback_(normalized_landmark_list, pose_landmarks.landmark_size());
-        delete[] normalized_landmark_list;
-        return absl::OkStatus();
-    };
-    auto status = graph_.ObserveOutputStream("pose_landmarks", packet_callback);
-    if (!status.ok()) {
-        std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (observe_callback_) {
+        landmark_buffer_.reserve(kPoseLandmarkCount);
+        auto packet_callback = [callback = observe_callback_, user_data = observe_user_data_, buffer = &landmark_buffer_](const mediapipe::Packet& packet) {
+            auto& pose_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
+            callback(FillLandmarkBuffer(pose_landmarks, buffer), pose_landmarks.landmark_size(), user_data);
+            return absl::OkStatus();
+        };
+        auto status = ObserveResults("pose_landmarks", packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    if (result_callback_) {
+        ReserveLandmarkResult(&result_buffer_, 1, kPoseLandmarkCount);
+        auto packet_callback = [callback = result_callback_, user_data = result_user_data_, buffer = &result_buffer_](const mediapipe::Packet& packet) {
+            auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+            // The graph tracks a single pose, so a frame has at most one.
+            const auto* pose_landmarks = bundle[0].IsEmpty() ? nullptr : &bundle[0].Get<mediapipe::NormalizedLandmarkList>();
+            callback(FillLandmarkResult(packet.Timestamp(), pose_landmarks, pose_landmarks ? 1 : 0, nullptr, buffer), user_data);
+            return absl::OkStatus();
+        };
+        auto status = ObserveResults(RESULT_STREAM_, packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
     }
 }
 
 void PoseTrackInterface::AddOutputStreamPoller() {
-    auto poller_or_status =  graph_.AddOutputStreamPoller("pose_landmarks");
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto poller_or_status = graph_.AddOutputStreamPoller("pose_landmarks");
+    if (!poller_or_status.ok()) {
+        std::cout << poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(poller_or_status.status());
+    }
     poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(poller_or_status.value()));
 }
 
 void PoseTrackInterface::GetOutput(NormalizedLandmark * normalized_landmark_list, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
     mediapipe::Packet packet;
-    if(poller_ && poller_->Next(&packet)) {
-        auto& multi_face_landmarks = packet.Get<std::vector<mediapipe::NormalizedLandmarkList>>();
-        // only one
-        for (const auto& face_landmarks : multi_face_landmarks) {
-            assert(size = face_landmarks.landmark_size());
-            for(int i = 0; i < size; ++i) {
-                const auto& face_landmark = face_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = face_landmark.x();
-                normalized_landmark_list[i].y_ = face_landmark.y();
-                normalized_landmark_list[i].z_ = face_landmark.z();
-                normalized_landmark_list[i].visibility_ = face_landmark.visibility();
-                normalized_landmark_list[i].presence_ = face_landmark.presence();
-            }
+    if(poller_ && NextResult(poller_.get(), &packet)) {
+        // pose_landmarks carries a single list, not a vector of them.
+        CopyLandmarks(packet.Get<mediapipe::NormalizedLandmarkList>(), normalized_landmark_list, size);
+    }
+}
+
+int PoseTrackInterface::TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us) {
+    mediapipe::Packet packet;
+    if (!TakeLatest(timeout_us, &packet)) {
+        return -1;
+    }
+    if (timestamp_us) {
+        *timestamp_us = packet.Timestamp().Value();
+    }
+    if (packet.IsEmpty()) {
+        return 0;
+    }
+    return CopyLandmarks(packet.Get<mediapipe::NormalizedLandmarkList>(), normalized_landmark_list, size);
+}
+
+std::vector<std::string> HolisticTrackInterface::OutputStreams() const {
+    return {"pose_landmarks", "face_landmarks", "left_hand_landmarks", "right_hand_landmarks"};
+}
+
+std::vector<std::string> HolisticTrackInterface::ResultStreams() const {
+    // Ordered as HolisticCallbackType.
+    return {"pose_landmarks", "face_landmarks", "left_hand_landmarks", "right_hand_landmarks"};
+}
+
+std::vector<TraceChannel> HolisticTrackInterface::TraceChannels() const {
+    // Ordered as HolisticCallbackType, like the result streams.
+    return {{"pose_landmarks", TRACE_LANDMARKS, 1, kPoseLandmarkCount * kLandmarkValues},
+            {"face_landmarks", TRACE_LANDMARKS, 1, kFaceLandmarkCount * kLandmarkValues},
+            {"left_hand_landmarks", TRACE_LANDMARKS, 1, kHandLandmarkCount * kLandmarkValues},
+            {"right_hand_landmarks", TRACE_LANDMARKS, 1, kHandLandmarkCount * kLandmarkValues}};
+}
+
+void HolisticTrackInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    const size_t counts[] = {kPoseLandmarkCount, kFaceLandmarkCount, kHandLandmarkCount, kHandLandmarkCount};
+    for (int i = 0; i < 4; ++i) {
+        if (!bundle[i].IsEmpty()) {
+            RecordLandmarks(bundle[i].Get<mediapipe::NormalizedLandmarkList>(), writer->Slot(i, 0), counts[i]);
         }
     }
 }
 
-void HolisticTrackInterface::SetObserveCallback(const landmark_callback & callback, const HolisticCallbackType& type) {
+void HolisticTrackInterface::SetResultCallback(const holistic_result_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_callback_ = callback;
+    result_user_data_ = user_data;
+}
+
+void HolisticTrackInterface::SetObserveCallback(const landmark_callback & callback, const HolisticCallbackType& type, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
     switch (type) {
         case HolisticCallbackType::POSE:
             pose_callback_ = callback;
+            pose_user_data_ = user_data;
             break;
         case HolisticCallbackType::FACE:
             face_callback_ = callback;
+            face_user_data_ = user_data;
             break;
         case HolisticCallbackType::LEFT_HAND:
             left_hand_callback_ = callback;
+            left_hand_user_data_ = user_data;
             break;
         case HolisticCallbackType::RIGHT_HAND:
             right_hand_callback_ = callback;
+            right_hand_user_data_ = user_data;
             break;
     }
 }
 
 void HolisticTrackInterface::Observe() {
+    std::lock_guard<std::mutex> lock(mutex_);
     if (pose_callback_) {
-        auto packet_callback = [&](const mediapipe::Packet& packet) {
+        pose_buffer_.reserve(kPoseLandmarkCount);
+        auto packet_callback = [callback = pose_callback_, user_data = pose_user_data_, buffer = &pose_buffer_](const mediapipe::Packet& packet) {
             auto& pose_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
-            auto normalized_landmark_list = new NormalizedLandmark[pose_landmarks.landmark_size()];
-            for(int i = 0; i< pose_landmarks.landmark_size(); ++i) {
-                const auto& pose_landmark = pose_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = pose_landmark.x();
-                normalized_landmark_list[i].y_ = pose_landmark.y();
-                normalized_landmark_list[i].z_ = pose_landmark.z();
-                normalized_landmark_list[i].visibility_ = pose_landmark.visibility();
-                normalized_landmark_list[i].presence_ = pose_landmark.presence();
-            }
-            pose_callback_(normalized_landmark_list, pose_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
+            callback(FillLandmarkBuffer(pose_landmarks, buffer), pose_landmarks.landmark_size(), user_data);
             return absl::OkStatus();
         };
-        auto status = graph_.ObserveOutputStream("pose_landmarks", packet_callback);
+        auto status = ObserveResults("pose_landmarks", packet_callback);
         if (!status.ok()) {
             std::cout << status.ToString() << std::endl ;
-            throw std::runtime_error(status.ToString());
+            throw StatusError(status);
         }
     }
     if (face_callback_) {
-        auto packet_callback = [&](const mediapipe::Packet& packet) {
+        face_buffer_.reserve(kFaceLandmarkCount);
+        auto packet_callback = [callback = face_callback_, user_data = face_user_data_, buffer = &face_buffer_](const mediapipe::Packet& packet) {
             auto& face_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
-            auto normalized_landmark_list = new NormalizedLandmark[face_landmarks.landmark_size()];
-            for(int i = 0; i< face_landmarks.landmark_size(); ++i) {
-                const auto& face_landmark = face_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = face_landmark.x();
-                normalized_landmark_list[i].y_ = face_landmark.y();
-                normalized_landmark_list[i].z_ = face_landmark.z();
-                normalized_landmark_list[i].visibility_ = face_landmark.visibility();
-                normalized_landmark_list[i].presence_ = face_landmark.presence();
-            }
-            pose_callback_(normalized_landmark_list, face_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
+            callback(FillLandmarkBuffer(face_landmarks, buffer), face_landmarks.landmark_size(), user_data);
             return absl::OkStatus();
         };
-        auto status = graph_.ObserveOutputStream("face_landmarks", packet_callback);
+        auto status = ObserveResults("face_landmarks", packet_callback);
         if (!status.ok()) {
             std::cout << status.ToString() << std::endl ;
-            throw std::runtime_error(status.ToString());
+            throw StatusError(status);
         }
     }
     if (left_hand_callback_) {
-        auto packet_callback = [&](const mediapipe::Packet& packet) {
+        left_hand_buffer_.reserve(kHandLandmarkCount);
+        auto packet_callback = [callback = left_hand_callback_, user_data = left_hand_user_data_, buffer = &left_hand_buffer_](const mediapipe::Packet& packet) {
             auto& left_hand_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
-            auto normalized_landmark_list = new NormalizedLandmark[left_hand_landmarks.landmark_size()];
-            for(int i = 0; i< left_hand_landmarks.landmark_size(); ++i) {
-                const auto& left_hand_landmark = left_hand_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = left_hand_landmark.x();
-                normalized_landmark_list[i].y_ = left_hand_landmark.y();
-                normalized_landmark_list[i].z_ = left_hand_landmark.z();
-                normalized_landmark_list[i].visibility_ = left_hand_landmark.visibility();
-                normalized_landmark_list[i].presence_ = left_hand_landmark.presence();
-            }
-            pose_callback_(normalized_landmark_list, left_hand_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
+            callback(FillLandmarkBuffer(left_hand_landmarks, buffer), left_hand_landmarks.landmark_size(), user_data);
             return absl::OkStatus();
         };
-        auto status = graph_.ObserveOutputStream("left_hand_landmarks", packet_callback);
+        auto status = ObserveResults("left_hand_landmarks", packet_callback);
         if (!status.ok()) {
             std::cout << status.ToString() << std::endl ;
-            throw std::runtime_error(status.ToString());
+            throw StatusError(status);
         }
     }
     if (right_hand_callback_) {
-        auto packet_callback = [&](const mediapipe::Packet& packet) {
+        right_hand_buffer_.reserve(kHandLandmarkCount);
+        auto packet_callback = [callback = right_hand_callback_, user_data = right_hand_user_data_, buffer = &right_hand_buffer_](const mediapipe::Packet& packet) {
             auto& right_hand_landmarks = packet.Get<mediapipe::NormalizedLandmarkList>();
-            auto normalized_landmark_list = new NormalizedLandmark[right_hand_landmarks.landmark_size()];
-            for(int i = 0; i< right_hand_landmarks.landmark_size(); ++i) {
-                const auto& right_hand_landmark = right_hand_landmarks.landmark(i);
-                normalized_landmark_list[i].x_ = right_hand_landmark.x();
-                normalized_landmark_list[i].y_ = right_hand_landmark.y();
-                normalized_landmark_list[i].z_ = right_hand_landmark.z();
-                normalized_landmark_list[i].visibility_ = right_hand_landmark.visibility();
-                normalized_landmark_list[i].presence_ = right_hand_landmark.presence();
+            callback(FillLandmarkBuffer(right_hand_landmarks, buffer), right_hand_landmarks.landmark_size(), user_data);
+            return absl::OkStatus();
+        };
+        auto status = ObserveResults("right_hand_landmarks", packet_callback);
+        if (!status.ok()) {
+            std::cout << status.ToString() << std::endl ;
+            throw StatusError(status);
+        }
+    }
+    if (result_callback_) {
+        // The four streams arrive aligned in one bundle, so no state is shared
+        // with the per-stream callbacks above.
+        const size_t counts[] = {kPoseLandmarkCount, kFaceLandmarkCount, kHandLandmarkCount, kHandLandmarkCount};
+        for (int i = 0; i < 4; ++i) {
+            result_buffers_[i].reserve(counts[i]);
+        }
+        auto packet_callback = [callback = result_callback_, user_data = result_user_data_, buffers = &result_buffers_[0], result = &result_](const mediapipe::Packet& packet) {
+            auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+            result->timestamp_us_ = packet.Timestamp().Value();
+            for (int i = 0; i < 4; ++i) {
+                result->present_[i] = !bundle[i].IsEmpty();
+                if (result->present_[i]) {
+                    const auto& landmarks = bundle[i].Get<mediapipe::NormalizedLandmarkList>();
+                    result->landmarks_[i] = FillLandmarkBuffer(landmarks, &buffers[i]);
+                    result->size_[i] = landmarks.landmark_size();
+                } else {
+                    result->landmarks_[i] = nullptr;
+                    result->size_[i] = 0;
+                }
             }
-            pose_callback_(normalized_landmark_list, right_hand_landmarks.landmark_size());
-            delete[] normalized_landmark_list;
+            callback(result, user_data);
             return absl::OkStatus();
         };
-        auto status = graph_.ObserveOutputStream("right_hand_landmarks", packet_callback);
+        auto status = ObserveResults(RESULT_STREAM_, packet_callback);
         if (!status.ok()) {
             std::cout << status.ToString() << std::endl ;
-            throw std::runtime_error(status.ToString());
+            throw StatusError(status);
         }
     }
 }
 
-void FaceBlendShapeInterface::SetObserveCallback(const blend_shape_callback & callback) {
+std::vector<std::string> FaceBlendShapeInterface::OutputStreams() const {
+    return {"landmarks_presence", "blendshapes"};
+}
+
+std::string FaceBlendShapeInterface::LatestStream() const {
+    return "blendshapes";
+}
+
+std::vector<std::string> FaceBlendShapeInterface::ResultStreams() const {
+    return {"blendshapes"};
+}
+
+std::vector<TraceChannel> FaceBlendShapeInterface::TraceChannels() const {
+    return {{"blendshapes", TRACE_SCORES, 1, kBlendShapeCount}};
+}
+
+void FaceBlendShapeInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    if (!bundle[0].IsEmpty()) {
+        CopyBlendShapes(bundle[0].Get<mediapipe::ClassificationList>(), writer->Slot(0, 0), kBlendShapeCount);
+    }
+}
+
+void FaceBlendShapeInterface::SetObserveCallback(const blend_shape_callback & callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
     observe_callback_ = callback;
+    observe_user_data_ = user_data;
 }
 
 void FaceBlendShapeInterface::Observe() {
-    auto packet_callback = [&](const mediapipe::Packet& packet) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blend_shape_buffer_.reserve(kBlendShapeCount);
+    auto packet_callback = [callback = observe_callback_, user_data = observe_user_data_, buffer = &blend_shape_buffer_](const mediapipe::Packet& packet) {
         auto& blend_shapes = packet.Get<mediapipe::ClassificationList>();
-        auto blend_shape_list = new float[blend_shapes.classification_size()];
-        for(int i = 0; i< blend_shapes.classification_size(); ++i) {
-            const auto& blend_shape = blend_shapes.classification(i);
-            blend_shape_list[i] = blend_shape.score();
+        if (buffer->size() < static_cast<size_t>(blend_shapes.classification_size())) {
+            buffer->resize(blend_shapes.classification_size());
+        }
+        auto* blend_shape_list = buffer->data();
+        for (const auto& blend_shape : blend_shapes.classification()) {
+            *blend_shape_list++ = blend_shape.score();
         }
-        observe_callback_(blend_shape_list, blend_shapes.classification_size());
-        delete[] blend_shape_list;
+        callback(buffer->data(), blend_shapes.classification_size(), user_data);
         return absl::OkStatus();
     };
-    auto status = graph_.ObserveOutputStream("blendshapes", packet_callback);
+    auto status = ObserveResults("blendshapes", packet_callback);
     if (!status.ok()) {
         std::cout << status.ToString() << std::endl ;
-        throw std::runtime_error(status.ToString());
+        throw StatusError(status);
     }
 }
 
 void FaceBlendShapeInterface::AddOutputStreamPoller() {
-    auto blend_shape_poller_or_status =  graph_.AddOutputStreamPoller("blendshapes");
-    auto presence_poller_or_status =  graph_.AddOutputStreamPoller("landmarks_presence");
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto blend_shape_poller_or_status = graph_.AddOutputStreamPoller("blendshapes");
+    if (!blend_shape_poller_or_status.ok()) {
+        std::cout << blend_shape_poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(blend_shape_poller_or_status.status());
+    }
+    auto presence_poller_or_status = graph_.AddOutputStreamPoller("landmarks_presence");
+    if (!presence_poller_or_status.ok()) {
+        std::cout << presence_poller_or_status.status().ToString() << std::endl ;
+        throw StatusError(presence_poller_or_status.status());
+    }
     poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(blend_shape_poller_or_status.value()));
     presence_poller_ = std::make_shared<mediapipe::OutputStreamPoller>(std::move(presence_poller_or_status.value()));
 }
 
 void FaceBlendShapeInterface::GetOutput(float * blend_shape_list, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
     mediapipe::Packet packet;
-    if(presence_poller_ && presence_poller_->Next(&packet)) {
+    if(presence_poller_ && NextResult(presence_poller_.get(), &packet)) {
         auto have = packet.Get<bool>();
         if(have){
-            if(poller_ && poller_->Next(&packet)) {
+            if(poller_ && NextResult(poller_.get(), &packet)) {
                 auto& blend_shapes = packet.Get<mediapipe::ClassificationList>();
-                assert(size = blend_shapes.classification_size());
-                for(int i = 0; i< size; ++i) {
-                    const auto& blend_shape = blend_shapes.classification(i);
+                auto count = std::min<size_t>(size, blend_shapes.classification_size());
+                for(size_t i = 0; i < count; ++i) {
+                    const auto& blend_shape = blend_shapes.classification(static_cast<int>(i));
                     blend_shape_list[i] = blend_shape.score();
                 }
             }
@@ -407,3 +1148,124 @@ void FaceBlendShapeInterface::GetOutput(float * blend_shape_list, size_t size) {
 
 }
 
+int FaceBlendShapeInterface::TryGetLatest(float* blend_shape_list, size_t size, int64_t timeout_us, int64_t* timestamp_us) {
+    mediapipe::Packet packet;
+    if (!TakeLatest(timeout_us, &packet)) {
+        return -1;
+    }
+    if (timestamp_us) {
+        *timestamp_us = packet.Timestamp().Value();
+    }
+    if (packet.IsEmpty()) {
+        return 0;
+    }
+    return CopyBlendShapes(packet.Get<mediapipe::ClassificationList>(), blend_shape_list, size);
+}
+
+std::vector<std::string> FaceMeshBlendShapeInterface::OutputStreams() const {
+    return {"landmarks_presence", "multi_face_landmarks", "blendshapes"};
+}
+
+std::string FaceMeshBlendShapeInterface::LatestStream() const {
+    return RESULT_STREAM_;
+}
+
+std::vector<std::string> FaceMeshBlendShapeInterface::ResultStreams() const {
+    return {"multi_face_landmarks", "blendshapes"};
+}
+
+std::vector<TraceChannel> FaceMeshBlendShapeInterface::TraceChannels() const {
+    return {{"face_landmarks", TRACE_LANDMARKS, 1, kFaceLandmarkCount * kLandmarkValues},
+            {"blendshapes", TRACE_SCORES, 1, kBlendShapeCount}};
+}
+
+void FaceMeshBlendShapeInterface::RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {
+    if (bundle[0].IsEmpty()) {
+        return;
+    }
+    auto& multi_face_landmarks = bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+    if (multi_face_landmarks.empty()) {
+        return;
+    }
+    RecordLandmarks(multi_face_landmarks[0], writer->Slot(0, 0), kFaceLandmarkCount);
+    if (!bundle[1].IsEmpty()) {
+        CopyBlendShapes(bundle[1].Get<mediapipe::ClassificationList>(), writer->Slot(1, 0), kBlendShapeCount);
+    }
+}
+
+void FaceMeshBlendShapeInterface::SetResultCallback(const face_result_callback& callback, void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result_callback_ = callback;
+    result_user_data_ = user_data;
+}
+
+void FaceMeshBlendShapeInterface::Observe() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!result_callback_) {
+        return;
+    }
+    landmark_buffer_.reserve(kFaceLandmarkCount);
+    blend_shape_buffer_.reserve(kBlendShapeCount);
+    auto packet_callback = [callback = result_callback_, user_data = result_user_data_, landmark_buffer = &landmark_buffer_,
+                            blend_shape_buffer = &blend_shape_buffer_, result = &result_](const mediapipe::Packet& packet) {
+        auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+        *result = {};
+        result->timestamp_us_ = packet.Timestamp().Value();
+        if (!bundle[0].IsEmpty()) {
+            auto& multi_face_landmarks = bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+            if (!multi_face_landmarks.empty()) {
+                result->present_ = 1;
+                result->landmarks_ = FillLandmarkBuffer(multi_face_landmarks[0], landmark_buffer);
+                result->landmark_count_ = multi_face_landmarks[0].landmark_size();
+            }
+        }
+        if (result->present_ && !bundle[1].IsEmpty()) {
+            auto& blend_shapes = bundle[1].Get<mediapipe::ClassificationList>();
+            if (blend_shape_buffer->size() < static_cast<size_t>(blend_shapes.classification_size())) {
+                blend_shape_buffer->resize(blend_shapes.classification_size());
+            }
+            result->blend_shape_count_ = CopyBlendShapes(blend_shapes, blend_shape_buffer->data(), blend_shape_buffer->size());
+            result->blend_shapes_ = blend_shape_buffer->data();
+        }
+        callback(result, user_data);
+        return absl::OkStatus();
+    };
+    auto status = ObserveResults(RESULT_STREAM_, packet_callback);
+    if (!status.ok()) {
+        std::cout << status.ToString() << std::endl ;
+        throw StatusError(status);
+    }
+}
+
+bool FaceMeshBlendShapeInterface::TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t landmark_size,
+                                               float* blend_shape_list, size_t blend_shape_size, int64_t timeout_us,
+                                               unsigned* landmarks_written, unsigned* blend_shapes_written,
+                                               int64_t* timestamp_us) {
+    mediapipe::Packet packet;
+    if (!TakeLatest(timeout_us, &packet)) {
+        return false;
+    }
+    if (timestamp_us) {
+        *timestamp_us = packet.Timestamp().Value();
+    }
+    auto& bundle = packet.Get<std::vector<mediapipe::Packet>>();
+    unsigned landmark_count = 0;
+    unsigned blend_shape_count = 0;
+    if (!bundle[0].IsEmpty()) {
+        auto& multi_face_landmarks = bundle[0].Get<std::vector<mediapipe::NormalizedLandmarkList>>();
+        if (!multi_face_landmarks.empty()) {
+            landmark_count = CopyLandmarks(multi_face_landmarks[0], normalized_landmark_list, landmark_size);
+            if (!bundle[1].IsEmpty()) {
+                blend_shape_count = CopyBlendShapes(bundle[1].Get<mediapipe::ClassificationList>(), blend_shape_list, blend_shape_size);
+            }
+        }
+    }
+    if (landmarks_written) {
+        *landmarks_written = landmark_count;
+    }
+    if (blend_shapes_written) {
+        *blend_shapes_written = blend_shape_count;
+    }
+    return true;
+}
+
@@ -2,37 +2,148 @@
 #define MEDIAPIPE_INTERFACE_HPP_
 
 #include <opencv2/opencv.hpp>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "mediapipe_struct.h"
+#include "mediapipe_stats.hpp"
+#include "mediapipe_submit_queue.hpp"
+#include "mediapipe_trace.hpp"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_pool.h"
+#include "mediapipe/framework/shared_executor.h"
+
+// Thrown for graph failures so that the C API can report the status code.
+class StatusError : public std::runtime_error {
+public:
+    explicit StatusError(const absl::Status& status) : std::runtime_error(status.ToString()), status_(status) {}
+
+    const absl::Status& status() const { return status_; }
+
+private:
+    absl::Status status_;
+};
+
+// Reusable storage behind the MpLandmarkResult handed to result callbacks.
+struct LandmarkResultBuffer {
+    std::vector<unsigned> offsets_;
+    std::vector<NormalizedLandmark> landmarks_;
+    std::vector<int> handedness_;
+    std::vector<float> scores_;
+    MpLandmarkResult result_{};
+};
 
 class MediapipeInterface {
 public:
     MediapipeInterface();
-    virtual ~MediapipeInterface() = default;
+    virtual ~MediapipeInterface();
 
 public:
     using MatCallback = std::function<void(const cv::Mat& frame)>;
 
-    void SetGraph(const std::string& graph_name);
+    void SetGraph(const std::string& graph_name, const MpOptions& options);
     void Start();
-    void Process(const cv::Mat& frame);
+    // Both Process overloads return false when the submission queue dropped
+    // the frame.
+    // Copies the frame into a buffer drawn from a per-interface pool.
+    bool Process(const cv::Mat& frame);
+    // Hands the caller's pixels to the graph in their native layout. With a
+    // release callback the buffer is borrowed and release is called, possibly
+    // on a graph thread, once the graph drops it; without one it is copied.
+    // A non-negative timestamp_us replaces the submission-time stamp and must
+    // increase strictly from frame to frame.
+    bool Process(const MpImage& image, frame_release_callback release, void* user_data, int64_t timestamp_us = -1);
+    // Appends every result to a trace file at path; must precede Start.
+    void Record(const std::string& path);
     void Stop();
+    MpQueueStats QueueStats() const;
+    // Safe to call from any thread at any time; it never takes mutex_.
+    MpStats Stats();
 
 protected:
+    // Streams the interface reads results from; everything else is dropped
+    // when the graph is pruned. The first one must fire on every frame, and
+    // its packets and bounds time the frames for Stats.
+    virtual std::vector<std::string> OutputStreams() const = 0;
+    // Streams gathered into one packet per timestamp on RESULT_STREAM_ when the
+    // graph is loaded, so that a single observer sees all of them together.
+    virtual std::vector<std::string> ResultStreams() const { return {}; }
+    // Stream whose newest packet, or timestamp bound, is kept for TakeLatest;
+    // none by default.
+    virtual std::string LatestStream() const { return ""; }
+    // Channels written by Record, none by default.
+    virtual std::vector<TraceChannel> TraceChannels() const { return {}; }
+    // Writes the slots of one frame's RESULT_STREAM_ bundle to writer.
+    virtual void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const {}
+
+    // Warm-up frames run at negative timestamps, before any real frame.
+    static bool IsWarmup(const mediapipe::Packet& packet) { return packet.Timestamp() < mediapipe::Timestamp(0); }
+    // Observes stream like CalculatorGraph::ObserveOutputStream, but never
+    // hands warm-up results to callback.
+    absl::Status ObserveResults(const std::string& stream, std::function<absl::Status(const mediapipe::Packet&)> callback,
+                                bool observe_timestamp_bounds = false);
+    // Polls the next packet that does not belong to a warm-up frame.
+    static bool NextResult(mediapipe::OutputStreamPoller* poller, mediapipe::Packet* packet);
+
+    // Waits up to timeout_us for a result newer than the last one taken and
+    // moves it to packet; an empty packet means the frame produced nothing.
+    // It does not take mutex_, so it never blocks Process.
+    bool TakeLatest(int64_t timeout_us, mediapipe::Packet* packet);
+
     // only for developer
     void SetPreviewCallback(const MatCallback& callback);
     void Preview();
 
+private:
+    // Stamps the frame, unless timestamp_us is given, and adds it to the input
+    // stream; mutex_ must be held.
+    bool AddFrame(std::unique_ptr<mediapipe::ImageFrame> input_frame, int64_t timestamp_us = -1);
+    // Pushes warmup_frames_ black frames through the graph one at a time.
+    void Warmup();
+    std::shared_ptr<mediapipe::ImageFrame> GetPooledFrame(int width, int height, mediapipe::ImageFormat::Format format);
+    static std::unique_ptr<mediapipe::ImageFrame> BorrowPooledFrame(const std::shared_ptr<mediapipe::ImageFrame>& pooled_frame);
+
 protected:
-    const std::string INPUT_STREAM_ = "input_video";
+    // Typical result sizes, reserved up front so that delivery never allocates.
+    static constexpr size_t kFaceLandmarkCount = 478;
+    static constexpr size_t kHandLandmarkCount = 21;
+    static constexpr size_t kPoseLandmarkCount = 33;
+    static constexpr size_t kBlendShapeCount = 52;
+
+    std::string input_stream_ = "input_video";
     const std::string OUTPUT_STREAM_ = "output_video";
+    const std::string RESULT_STREAM_ = "library_result";
+    // Declared before graph_, so that it outlives every observer callback.
+    std::unique_ptr<TraceWriter> trace_writer_{nullptr};
+    // The default executor of graph_ with shared_executor_, whose CPU time Stats
+    // reports. Set before the graph starts.
+    std::shared_ptr<mediapipe::SharedExecutor> shared_executor_{nullptr};
     mediapipe::CalculatorGraph graph_;
+    bool has_result_stream_{false};
     MatCallback preview_callback_;
+    // Serializes the calls made on one handle.
+    std::mutex mutex_;
+    int64_t last_timestamp_us_{-1};
+    std::shared_ptr<mediapipe::ImageFramePool> frame_pool_{nullptr};
+    int frame_pool_size_{4};
+    std::shared_ptr<SubmitQueue> submit_queue_{nullptr};
+    RuntimeStats stats_;
+    MpStartupTimings startup_{};
+    int warmup_frames_{0};
+    int warmup_width_{640};
+    int warmup_height_{480};
+    // Latest-result slot, guarded by its own mutex so that readers and the
+    // graph never wait on mutex_.
+    std::mutex latest_mutex_;
+    std::condition_variable latest_ready_;
+    mediapipe::Packet latest_packet_;
+    bool latest_fresh_{false};
 };
 
 class FaceMeshInterface final : public MediapipeInterface {
@@ -40,14 +151,30 @@ public:
     FaceMeshInterface() = default;
     ~FaceMeshInterface() = default;
 
-    void SetObserveCallback(const landmark_callback& callback);
+    void SetObserveCallback(const landmark_callback& callback, void* user_data);
+    void SetResultCallback(const landmark_result_callback& callback, void* user_data);
     void Observe();
 
     void AddOutputStreamPoller();
     void GetOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
+    // Returns the number of values written from the newest result, or -1 when
+    // no new result arrives within timeout_us.
+    int TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us);
 
 private:
-    landmark_callback observe_callback_;
+    std::vector<std::string> OutputStreams() const override;
+    std::string LatestStream() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
+    landmark_callback observe_callback_{nullptr};
+    void* observe_user_data_{nullptr};
+    // Reused by every observe callback; callbacks of one stream never overlap.
+    std::vector<NormalizedLandmark> landmark_buffer_;
+    landmark_result_callback result_callback_{nullptr};
+    void* result_user_data_{nullptr};
+    LandmarkResultBuffer result_buffer_;
     std::shared_ptr<mediapipe::OutputStreamPoller> landmark_poller_{nullptr};
     std::shared_ptr<mediapipe::OutputStreamPoller> presence_poller_{nullptr};
 };
@@ -57,14 +184,27 @@ public:
     HandTrackInterface() = default;
     ~HandTrackInterface() = default;
 
-    void SetObserveCallback(const landmark_callback& callback);
+    void SetObserveCallback(const landmark_callback& callback, void* user_data);
+    void SetResultCallback(const landmark_result_callback& callback, void* user_data);
     void Observe();
     
     void AddOutputStreamPoller();
     void GetOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
+    int TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us);
 
 private:
-    landmark_callback observe_callback_;
+    std::vector<std::string> OutputStreams() const override;
+    std::string LatestStream() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
+    landmark_callback observe_callback_{nullptr};
+    void* observe_user_data_{nullptr};
+    std::vector<NormalizedLandmark> landmark_buffer_;
+    landmark_result_callback result_callback_{nullptr};
+    void* result_user_data_{nullptr};
+    LandmarkResultBuffer result_buffer_;
     std::shared_ptr<mediapipe::OutputStreamPoller> poller_{nullptr};
 };
 
@@ -73,14 +213,27 @@ public:
     PoseTrackInterface() = default;
     ~PoseTrackInterface() = default;
 
-    void SetObserveCallback(const landmark_callback& callback);
+    void SetObserveCallback(const landmark_callback& callback, void* user_data);
+    void SetResultCallback(const landmark_result_callback& callback, void* user_data);
     void Observe();
 
     void AddOutputStreamPoller();
     void GetOutput(NormalizedLandmark* normalized_landmark_list, size_t size);
+    int TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t size, int64_t timeout_us, int64_t* timestamp_us);
 
 private:
-    landmark_callback observe_callback_;
+    std::vector<std::string> OutputStreams() const override;
+    std::string LatestStream() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
+    landmark_callback observe_callback_{nullptr};
+    void* observe_user_data_{nullptr};
+    std::vector<NormalizedLandmark> landmark_buffer_;
+    landmark_result_callback result_callback_{nullptr};
+    void* result_user_data_{nullptr};
+    LandmarkResultBuffer result_buffer_;
     std::shared_ptr<mediapipe::OutputStreamPoller> poller_{nullptr};
 };
 
@@ -89,17 +242,37 @@ public:
     HolisticTrackInterface() = default;
     ~HolisticTrackInterface() = default;
 
-    void SetObserveCallback(const landmark_callback& callback, const HolisticCallbackType& type);
+    void SetObserveCallback(const landmark_callback& callback, const HolisticCallbackType& type, void* user_data);
+    void SetResultCallback(const holistic_result_callback& callback, void* user_data);
     void Observe();
 
     // void AddOutputStreamPoller(const std::string& stream_name);
     // void GetOutput(NormalizedLandmark* normalized_landmark_list, size_t* size);
 
 private:
+    std::vector<std::string> OutputStreams() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
     landmark_callback pose_callback_;
     landmark_callback face_callback_;
     landmark_callback left_hand_callback_;
     landmark_callback right_hand_callback_;
+    void* pose_user_data_{nullptr};
+    void* face_user_data_{nullptr};
+    void* left_hand_user_data_{nullptr};
+    void* right_hand_user_data_{nullptr};
+    // One buffer per stream, as the four streams are delivered concurrently.
+    std::vector<NormalizedLandmark> pose_buffer_;
+    std::vector<NormalizedLandmark> face_buffer_;
+    std::vector<NormalizedLandmark> left_hand_buffer_;
+    std::vector<NormalizedLandmark> right_hand_buffer_;
+    holistic_result_callback result_callback_{nullptr};
+    void* result_user_data_{nullptr};
+    // Storage behind result_, one set per HolisticCallbackType.
+    std::vector<NormalizedLandmark> result_buffers_[4];
+    MpHolisticResult result_{};
 
     // mediapipe::OutputStreamPoller pose_poller_;
     // mediapipe::OutputStreamPoller face_poller_;
@@ -112,16 +285,54 @@ public:
     FaceBlendShapeInterface() = default;
     ~FaceBlendShapeInterface() = default;
 
-    void SetObserveCallback(const blend_shape_callback& callback);
+    void SetObserveCallback(const blend_shape_callback& callback, void* user_data);
     void Observe();
 
     void AddOutputStreamPoller();
     void GetOutput(float* blend_shape_list, size_t size);
+    int TryGetLatest(float* blend_shape_list, size_t size, int64_t timeout_us, int64_t* timestamp_us);
 
 private:
+    std::vector<std::string> OutputStreams() const override;
+    std::string LatestStream() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
     blend_shape_callback observe_callback_;
+    void* observe_user_data_{nullptr};
+    std::vector<float> blend_shape_buffer_;
     std::shared_ptr<mediapipe::OutputStreamPoller> poller_{nullptr};
     std::shared_ptr<mediapipe::OutputStreamPoller> presence_poller_{nullptr};
 };
 
+// Face mesh and blendshapes from one detection and landmark pass.
+class FaceMeshBlendShapeInterface final : public MediapipeInterface {
+public:
+    FaceMeshBlendShapeInterface() = default;
+    ~FaceMeshBlendShapeInterface() = default;
+
+    void SetResultCallback(const face_result_callback& callback, void* user_data);
+    void Observe();
+
+    // Copies the newest result, writing the counts of landmarks and scores,
+    // or returns false when no new result arrives within timeout_us.
+    bool TryGetLatest(NormalizedLandmark* normalized_landmark_list, size_t landmark_size, float* blend_shape_list,
+                      size_t blend_shape_size, int64_t timeout_us, unsigned* landmarks_written,
+                      unsigned* blend_shapes_written, int64_t* timestamp_us);
+
+private:
+    std::vector<std::string> OutputStreams() const override;
+    std::string LatestStream() const override;
+    std::vector<std::string> ResultStreams() const override;
+    std::vector<TraceChannel> TraceChannels() const override;
+    void RecordResult(const std::vector<mediapipe::Packet>& bundle, TraceWriter* writer) const override;
+
+    face_result_callback result_callback_{nullptr};
+    void* result_user_data_{nullptr};
+    std::vector<NormalizedLandmark> landmark_buffer_;
+    std::vector<float> blend_shape_buffer_;
+    MpFaceResult result_{};
+};
+
 #endif
\ No newline at end of file
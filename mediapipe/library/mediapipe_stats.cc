@@ -0,0 +1,131 @@
+#include "mediapipe_stats.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "absl/strings/match.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace {
+
+// Frames covered by the rolling rates and latency percentiles.
+constexpr size_t kWindow = 256;
+// Frames waiting for a result before the oldest is written off, so that a
+// graph that never reaches the result stream cannot grow the queue unbounded.
+constexpr size_t kMaxPending = 1024;
+
+int64_t Percentile(std::vector<int64_t>* values, int percent) {
+    auto index = std::min(values->size() - 1, values->size() * percent / 100);
+    std::nth_element(values->begin(), values->begin() + index, values->end());
+    return (*values)[index];
+}
+
+}  // namespace
+
+RuntimeStats::RuntimeStats() : latencies_us_(kWindow), input_times_(kWindow), output_times_(kWindow) {}
+
+void RuntimeStats::OnInput(int64_t timestamp_us) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.size() >= kMaxPending) {
+        pending_.pop_front();
+        ++frames_dropped_;
+    }
+    pending_.emplace_back(timestamp_us, now);
+    input_times_[next_input_++ % kWindow] = now;
+    ++frames_in_;
+}
+
+void RuntimeStats::OnOutput(int64_t timestamp_us) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!pending_.empty() && pending_.front().first < timestamp_us) {
+        pending_.pop_front();
+        ++frames_dropped_;
+    }
+    if (pending_.empty() || pending_.front().first != timestamp_us) {
+        return;
+    }
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - pending_.front().second);
+    pending_.pop_front();
+    latencies_us_[next_latency_++ % kWindow] = latency.count();
+    output_times_[next_output_++ % kWindow] = now;
+    ++frames_out_;
+}
+
+double RuntimeStats::Rate(const std::vector<Clock::time_point>& times, size_t count) {
+    // count frames were recorded in total; once the ring has wrapped the
+    // oldest one sits in the slot written next.
+    auto recorded = std::min(count, kWindow);
+    if (recorded < 2) {
+        return 0.;
+    }
+    auto oldest = times[count > kWindow ? count % kWindow : 0];
+    auto newest = times[(count - 1) % kWindow];
+    auto seconds = std::chrono::duration<double>(newest - oldest).count();
+    return seconds > 0. ? (recorded - 1) / seconds : 0.;
+}
+
+void RuntimeStats::SetStartupTimings(const MpStartupTimings& timings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    startup_ = timings;
+}
+
+void RuntimeStats::Fill(MpStats* stats) const {
+    std::vector<int64_t> latencies;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats->input_fps_ = Rate(input_times_, next_input_);
+        stats->output_fps_ = Rate(output_times_, next_output_);
+        stats->frames_in_ = frames_in_;
+        stats->frames_out_ = frames_out_;
+        stats->frames_dropped_ = frames_dropped_;
+        stats->startup_ = startup_;
+        latencies.assign(latencies_us_.begin(), latencies_us_.begin() + std::min(next_latency_, kWindow));
+    }
+    if (latencies.empty()) {
+        stats->latency_p50_us_ = stats->latency_p90_us_ = stats->latency_p99_us_ = 0;
+        return;
+    }
+    stats->latency_p50_us_ = Percentile(&latencies, 50);
+    stats->latency_p90_us_ = Percentile(&latencies, 90);
+    stats->latency_p99_us_ = Percentile(&latencies, 99);
+}
+
+uint64_t FlowLimiterDroppedFrames(mediapipe::CalculatorGraph* graph) {
+    uint64_t dropped = 0;
+    for (const auto& counter : graph->GetCounterFactory()->GetCounterSet()->GetCountersValues()) {
+        if (absl::EndsWith(counter.first, "-DroppedFrames")) {
+            dropped += counter.second;
+        }
+    }
+    return dropped;
+}
+
+void FillCalculatorStats(mediapipe::CalculatorGraph* graph, MpStats* stats) {
+    stats->calculator_count_ = 0;
+    std::vector<mediapipe::CalculatorProfile> profiles;
+    if (!graph->profiler() || !graph->profiler()->GetCalculatorProfiles(&profiles).ok()) {
+        return;
+    }
+    std::vector<MpCalculatorStats> calculators;
+    calculators.reserve(profiles.size());
+    for (const auto& profile : profiles) {
+        MpCalculatorStats calculator{};
+        for (auto count : profile.process_runtime().count()) {
+            calculator.calls_ += count;
+        }
+        if (calculator.calls_ == 0) {
+            continue;
+        }
+        calculator.mean_us_ = static_cast<double>(profile.process_runtime().total()) / calculator.calls_;
+        std::strncpy(calculator.name_, profile.name().c_str(), sizeof(calculator.name_) - 1);
+        calculators.push_back(calculator);
+    }
+    auto count = std::min<size_t>(calculators.size(), MP_STATS_TOP_CALCULATORS);
+    std::partial_sort(calculators.begin(), calculators.begin() + count, calculators.end(),
+                      [](const MpCalculatorStats& a, const MpCalculatorStats& b) { return a.mean_us_ > b.mean_us_; });
+    std::copy(calculators.begin(), calculators.begin() + count, stats->calculators_);
+    stats->calculator_count_ = static_cast<unsigned>(count);
+}
@@ -0,0 +1,57 @@
+#ifndef MEDIAPIPE_STATS_HPP_
+#define MEDIAPIPE_STATS_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "mediapipe_struct.h"
+#include "mediapipe/framework/calculator_framework.h"
+
+// Rolling frame rate and end-to-end latency of one handle. Every frame costs
+// one timestamped entry and a few ring writes under a short lock; percentiles
+// are only computed when Fill is called.
+class RuntimeStats {
+public:
+    RuntimeStats();
+
+    // Records a frame entering the handle with its graph timestamp.
+    void OnInput(int64_t timestamp_us);
+    // Records that every frame up to timestamp_us has settled on the result
+    // stream; earlier frames that were still pending produced nothing.
+    void OnOutput(int64_t timestamp_us);
+    void SetStartupTimings(const MpStartupTimings& timings);
+    // Fills the rate, latency, frame count and startup fields of stats.
+    void Fill(MpStats* stats) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Frames per second over the ring of the last count recorded times.
+    static double Rate(const std::vector<Clock::time_point>& times, size_t count);
+
+    mutable std::mutex mutex_;
+    std::deque<std::pair<int64_t, Clock::time_point>> pending_;
+    // Rings over the most recent frames.
+    std::vector<int64_t> latencies_us_;
+    std::vector<Clock::time_point> input_times_;
+    std::vector<Clock::time_point> output_times_;
+    size_t next_latency_{0};
+    size_t next_input_{0};
+    size_t next_output_{0};
+    uint64_t frames_in_{0};
+    uint64_t frames_out_{0};
+    uint64_t frames_dropped_{0};
+    MpStartupTimings startup_{};
+};
+
+// Sums the DroppedFrames counters of every FlowLimiterCalculator in graph.
+uint64_t FlowLimiterDroppedFrames(mediapipe::CalculatorGraph* graph);
+
+// Writes the calculators with the highest mean Process time to stats, as far
+// as the graph profiler is enabled.
+void FillCalculatorStats(mediapipe::CalculatorGraph* graph, MpStats* stats);
+
+#endif
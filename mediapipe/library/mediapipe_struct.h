@@ -15,9 +15,210 @@ struct Landmark {
 
 typedef Landmark NormalizedLandmark;
 
-typedef void (*landmark_callback)(NormalizedLandmark* normalized_landmark_list, unsigned size);
+// Result of every library call.
+enum MpStatus {
+    MP_OK = 0,
+    // Bad handle, null pointer or malformed graph.
+    MP_INVALID_ARGUMENT,
+    // Missing graph file or stream.
+    MP_NOT_FOUND,
+    // Call out of order, e.g. a frame before Start.
+    MP_FAILED_PRECONDITION,
+    // The frame was dropped, or no result is ready yet.
+    MP_UNAVAILABLE,
+    // Any other graph error; see GetLastErrorMessage.
+    MP_INTERNAL
+};
+
+// What happens to a frame that finds the submission queue full.
+enum MpDropPolicy {
+    // Evict the oldest queued frame, keeping latency low.
+    MP_DROP_OLDEST,
+    // Reject the new frame with MP_UNAVAILABLE.
+    MP_DROP_NEWEST,
+    // Wait in the Process call until there is room.
+    MP_BLOCK
+};
+
+struct MpQueueStats {
+    // Frames taken by Process calls, including those evicted later.
+    unsigned long long accepted_;
+    // Frames rejected, evicted, or refused by the graph.
+    unsigned long long dropped_;
+    // Frames waiting in the submission queue.
+    unsigned queued_;
+    // Frames handed to the graph and not yet released by it.
+    unsigned in_flight_;
+};
+
+// Calculators listed in MpStats, slowest first.
+#define MP_STATS_TOP_CALCULATORS 5
+
+struct MpCalculatorStats {
+    // Node name, truncated to fit.
+    char name_[64];
+    // Mean Process time, in microseconds.
+    double mean_us_;
+    unsigned long long calls_;
+};
+
+// Time spent in each startup phase, in microseconds.
+struct MpStartupTimings {
+    // Reading the graph file, or finding an embedded graph.
+    long long load_us_;
+    // Decoding the text or binary config.
+    long long parse_us_;
+    // Subgraph expansion and validation.
+    long long initialize_us_;
+    // Opening every calculator, which loads the models.
+    long long start_us_;
+    // Running the warm-up frames.
+    long long warmup_us_;
+};
+
+// Runtime statistics of one handle. Rates and latencies cover the most recent
+// few hundred frames; counts are totals since creation.
+struct MpStats {
+    double input_fps_;
+    double output_fps_;
+    // End-to-end latency from the process call to the result, in microseconds.
+    long long latency_p50_us_;
+    long long latency_p90_us_;
+    long long latency_p99_us_;
+    // Frames passed to the process calls.
+    unsigned long long frames_in_;
+    // Frames that reached the result stream.
+    unsigned long long frames_out_;
+    // Frames that never reached it, for any reason.
+    unsigned long long frames_dropped_;
+    // The subset of those discarded by FlowLimiterCalculator nodes.
+    unsigned long long flow_limiter_dropped_;
+    // Entries used in calculators_; 0 unless MpOptions.enable_profiler_ is set.
+    unsigned calculator_count_;
+    MpCalculatorStats calculators_[MP_STATS_TOP_CALCULATORS];
+    MpStartupTimings startup_;
+    // CPU time the graph used on the shared executor, in microseconds; 0
+    // without shared_executor_.
+    long long executor_cpu_us_;
+};
+
+// Opaque handle to one graph instance. Every handle owns its own graph, so any
+// number of handles can run concurrently in one process. Calls on the same
+// handle are serialized internally and may come from any thread.
+typedef void* MpHandle;
+
+// Creation options. A zero-initialized struct (or a null pointer) selects the
+// defaults for every field.
+struct MpOptions {
+    // Graph input stream that receives frames, "input_video" when null.
+    const char* input_stream_;
+    // Number of pooled frames kept for copying Process calls, 4 when 0.
+    int frame_pool_size_;
+    // Nonzero removes the graph's FlowLimiterCalculator so that every frame is
+    // processed, e.g. for recorded video. Process then blocks while the graph
+    // queues are full instead of dropping frames.
+    int offline_;
+    // Per-stream queue bound used in offline mode, 16 when 0.
+    int max_queue_size_;
+    // Nonzero drops every node that does not feed the streams the interface
+    // reads, e.g. renderers, when the graph is loaded. Graphs whose flow limiter
+    // waits on a dropped renderer fail to load; use their headless variants.
+    int prune_outputs_;
+    // Frames that may wait for the graph. 0 submits each frame on the calling
+    // thread; otherwise Process only enqueues and a worker feeds the graph.
+    int submit_queue_size_;
+    MpDropPolicy drop_policy_;
+    // Frames the worker lets the graph hold at once, 2 when 0.
+    int max_in_flight_;
+    // Nonzero turns the graph profiler on, so that Get*Stats reports the
+    // slowest calculators. Off by default, as it times every Process call.
+    int enable_profiler_;
+    // Black frames pushed through the graph before Start returns, so that the
+    // first real frame does not pay for model preparation. Their results are
+    // never delivered.
+    int warmup_frames_;
+    // Size of the warm-up frames, 640x480 when 0; ideally the camera size.
+    int warmup_width_;
+    int warmup_height_;
+    // Threads of the graph's default executor; 0 keeps the graph's choice,
+    // which is up to one per core.
+    int num_threads_;
+    // Nice priority level of those threads, 0 for unchanged.
+    int nice_priority_level_;
+    // Name prefix of those threads, shown by debuggers; may be null.
+    const char* thread_name_prefix_;
+    // Threads of every TFLite interpreter and XNNPACK delegate, 0 for the
+    // calculator defaults.
+    int inference_threads_;
+    // Nonzero runs the graph on one pool of threads shared by every handle
+    // created with this flag. The first of them sizes it through the fields
+    // above, and it lives until the last of them is released. While several
+    // handles have work, each gets CPU time in proportion to its
+    // executor_weight_, and MpStats reports the CPU time each one used.
+    int shared_executor_;
+    // Nonzero runs the graph on a WorkStealingExecutor, whose threads keep
+    // their own task queues and take tasks from each other when idle,
+    // instead of sharing one queue. Together with shared_executor_, every
+    // such handle shares one WorkStealingExecutor, without weights.
+    int work_stealing_;
+    // Share of the shared executor's threads, 1 when 0.
+    int executor_weight_;
+};
+
+// Pixel layouts accepted by *ProcessImage. NV12 and I420 planes must be
+// contiguous, with chroma rows following the luma rows.
+enum MpImageFormat {
+    IMAGE_SRGB,
+    IMAGE_SRGBA,
+    IMAGE_BGR,
+    IMAGE_BGRA,
+    IMAGE_NV12,
+    IMAGE_I420
+};
+
+// Caller-owned pixels submitted in their native layout.
+struct MpImage {
+    unsigned char* data_;
+    int width_;
+    int height_;
+    // Bytes per row (of the luma plane for YUV), 0 for tightly packed rows.
+    int width_step_;
+    MpImageFormat format_;
+};
+
+// Tells the caller that the graph no longer references a submitted buffer.
+typedef void (*frame_release_callback)(unsigned char* data, void* user_data);
 
-typedef void (*blend_shape_callback)(float* blend_shape, unsigned size);
+// Observe callbacks receive a view into a buffer owned by the handle, which
+// is reused for the next result; copy anything needed after returning.
+typedef void (*landmark_callback)(NormalizedLandmark* normalized_landmark_list, unsigned size, void* user_data);
+
+typedef void (*blend_shape_callback)(float* blend_shape, unsigned size, void* user_data);
+
+enum MpHandedness {
+    HANDEDNESS_NONE = -1,
+    HANDEDNESS_LEFT,
+    HANDEDNESS_RIGHT
+};
+
+// Every face or hand found in one frame, packed into parallel arrays.
+struct MpLandmarkResult {
+    // Timestamp of the input frame, in microseconds.
+    long long timestamp_us_;
+    // Number of detected instances; 0 when the frame has none.
+    unsigned count_;
+    // count_ + 1 entries; instance i owns landmarks_[offsets_[i]] up to
+    // landmarks_[offsets_[i + 1]].
+    const unsigned* offsets_;
+    const NormalizedLandmark* landmarks_;
+    // count_ entries each. Faces report HANDEDNESS_NONE with a score of 0.
+    const int* handedness_;
+    const float* scores_;
+};
+
+// Called once per processed frame, with the same lifetime rules as the
+// landmark callbacks.
+typedef void (*landmark_result_callback)(const MpLandmarkResult* result, void* user_data);
 
 enum HolisticCallbackType {
     POSE,
@@ -26,8 +227,66 @@ enum HolisticCallbackType {
     RIGHT_HAND
 };
 
+// All four holistic landmark sets of one frame, indexed by HolisticCallbackType.
+struct MpHolisticResult {
+    // Timestamp of the input frame, in microseconds.
+    long long timestamp_us_;
+    // Nonzero when the part was detected; absent parts have size 0.
+    int present_[4];
+    unsigned size_[4];
+    const NormalizedLandmark* landmarks_[4];
+};
+
+// Called once per processed frame, with the same lifetime rules as the
+// landmark callbacks.
+typedef void (*holistic_result_callback)(const MpHolisticResult* result, void* user_data);
+
+// Landmarks and blendshapes of the first face of one frame, both taken from
+// the same landmark pass.
+struct MpFaceResult {
+    // Timestamp of the input frame, in microseconds.
+    long long timestamp_us_;
+    // Nonzero when a face was detected; otherwise both counts are 0.
+    int present_;
+    unsigned landmark_count_;
+    const NormalizedLandmark* landmarks_;
+    // Scores in the blendshape model's category order, the neutral one first.
+    unsigned blend_shape_count_;
+    const float* blend_shapes_;
+};
+
+// Called once per processed frame, with the same lifetime rules as the
+// landmark callbacks.
+typedef void (*face_result_callback)(const MpFaceResult* result, void* user_data);
+
+// Opaque handle to a trace file opened for reading.
+typedef void* MpTraceHandle;
+
+enum MpTraceChannelKind {
+    // Each slot holds landmarks, laid out as NormalizedLandmark.
+    TRACE_LANDMARKS,
+    // Each slot holds plain scores.
+    TRACE_SCORES
+};
+
+// One result kind recorded in a trace, e.g. the pose landmarks. Every frame
+// has slots_ slots, such as one per tracked hand, of values_per_slot_ floats.
+struct MpTraceChannel {
+    char name_[32];
+    MpTraceChannelKind kind_;
+    unsigned slots_;
+    unsigned values_per_slot_;
+};
+
+struct MpTraceInfo {
+    unsigned long long frame_count_;
+    long long first_timestamp_us_;
+    long long last_timestamp_us_;
+    unsigned channel_count_;
+};
+
 #ifdef __cplusplus
 }
 #endif
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,132 @@
+#include "mediapipe_submit_queue.hpp"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+
+SubmitQueue::SubmitQueue(size_t capacity, MpDropPolicy policy, size_t max_in_flight)
+    : capacity_(capacity), policy_(policy), max_in_flight_(max_in_flight) {}
+
+SubmitQueue::~SubmitQueue() {
+    Stop();
+}
+
+void SubmitQueue::Start(Sink sink) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = std::move(sink);
+    error_ = absl::OkStatus();
+    stopping_ = false;
+    if (capacity_ > 0 && !worker_.joinable()) {
+        worker_ = std::thread([this] { Run(); });
+    }
+}
+
+absl::StatusOr<bool> SubmitQueue::Push(std::unique_ptr<mediapipe::ImageFrame> frame, mediapipe::Timestamp timestamp) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!error_.ok()) {
+        return error_;
+    }
+    if (!sink_) {
+        return absl::FailedPreconditionError("frames submitted before Start");
+    }
+    if (stopping_) {
+        return absl::FailedPreconditionError("frames submitted after Stop");
+    }
+    if (capacity_ == 0) {
+        ++accepted_;
+        lock.unlock();
+        auto status = Submit({std::move(frame), timestamp});
+        if (!status.ok()) {
+            return status;
+        }
+        return true;
+    }
+    Pending evicted;
+    if (pending_.size() >= capacity_) {
+        switch (policy_) {
+            case MP_DROP_NEWEST:
+                ++dropped_;
+                lock.unlock();
+                // The frame, and with it any release callback, goes now.
+                return false;
+            case MP_BLOCK:
+                changed_.wait(lock, [this] { return stopping_ || pending_.size() < capacity_; });
+                if (stopping_) {
+                    // The worker is gone, so the frame would never be submitted.
+                    return absl::FailedPreconditionError("frames submitted after Stop");
+                }
+                break;
+            default:
+                evicted = std::move(pending_.front());
+                pending_.pop_front();
+                ++dropped_;
+                break;
+        }
+    }
+    pending_.push_back({std::move(frame), timestamp});
+    ++accepted_;
+    lock.unlock();
+    changed_.notify_all();
+    return true;
+}
+
+void SubmitQueue::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+MpQueueStats SubmitQueue::Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {accepted_, dropped_, static_cast<unsigned>(pending_.size()), static_cast<unsigned>(in_flight_)};
+}
+
+absl::Status SubmitQueue::Submit(Pending pending) {
+    // The graph borrows the pixels; the in-flight count drops once it releases them.
+    std::shared_ptr<mediapipe::ImageFrame> frame(pending.frame_.release());
+    auto self = shared_from_this();
+    auto tracked_frame = absl::make_unique<mediapipe::ImageFrame>(
+        frame->Format(), frame->Width(), frame->Height(), frame->WidthStep(), frame->MutablePixelData(),
+        [frame, self](uint8_t*) {
+            {
+                std::lock_guard<std::mutex> lock(self->mutex_);
+                --self->in_flight_;
+            }
+            self->changed_.notify_all();
+        });
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++in_flight_;
+    }
+    auto status = sink_(mediapipe::Adopt(tracked_frame.release()).At(pending.timestamp_));
+    if (!status.ok()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++dropped_;
+    }
+    return status;
+}
+
+void SubmitQueue::Run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // Queued frames are flushed regardless of the in-flight bound on Stop.
+        changed_.wait(lock, [this] { return stopping_ || (!pending_.empty() && in_flight_ < max_in_flight_); });
+        if (pending_.empty()) {
+            return;
+        }
+        auto pending = std::move(pending_.front());
+        pending_.pop_front();
+        lock.unlock();
+        changed_.notify_all();
+        auto status = Submit(std::move(pending));
+        lock.lock();
+        if (!status.ok() && error_.ok()) {
+            error_ = status;
+        }
+    }
+}
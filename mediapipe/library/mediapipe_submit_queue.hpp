@@ -0,0 +1,63 @@
+#ifndef MEDIAPIPE_SUBMIT_QUEUE_HPP_
+#define MEDIAPIPE_SUBMIT_QUEUE_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "mediapipe_struct.h"
+#include "absl/status/statusor.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/timestamp.h"
+
+// Bounded hand-off of stamped frames from the caller to a graph input stream.
+// With a capacity of 0 every frame is submitted on the calling thread;
+// otherwise a worker thread feeds the graph while at most max_in_flight frames
+// are held by it, and a full queue applies the drop policy. Frames count as in
+// flight until the graph releases their pixels.
+class SubmitQueue : public std::enable_shared_from_this<SubmitQueue> {
+public:
+    using Sink = std::function<absl::Status(mediapipe::Packet packet)>;
+
+    SubmitQueue(size_t capacity, MpDropPolicy policy, size_t max_in_flight);
+    ~SubmitQueue();
+
+    void Start(Sink sink);
+    // Returns false when the frame was dropped, the first error the graph
+    // reported for any frame, or FailedPreconditionError outside of Start and
+    // Stop.
+    absl::StatusOr<bool> Push(std::unique_ptr<mediapipe::ImageFrame> frame, mediapipe::Timestamp timestamp);
+    // Submits every queued frame and joins the worker.
+    void Stop();
+    MpQueueStats Stats() const;
+
+private:
+    struct Pending {
+        std::unique_ptr<mediapipe::ImageFrame> frame_;
+        mediapipe::Timestamp timestamp_;
+    };
+
+    absl::Status Submit(Pending pending);
+    void Run();
+
+    const size_t capacity_;
+    const MpDropPolicy policy_;
+    const size_t max_in_flight_;
+    Sink sink_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<Pending> pending_;
+    size_t in_flight_{0};
+    uint64_t accepted_{0};
+    uint64_t dropped_{0};
+    absl::Status error_;
+    bool stopping_{false};
+    std::thread worker_;
+};
+
+#endif
@@ -0,0 +1,354 @@
+#include "mediapipe_trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kTraceMagic[4] = {'M', 'P', 'T', 'R'};
+constexpr char kBlockMagic[4] = {'M', 'P', 'T', 'B'};
+
+struct TraceFileHeader {
+    char magic_[4];
+    uint32_t version_;
+    uint32_t channel_count_;
+    uint32_t block_frames_;
+};
+
+size_t PresenceWords(size_t bits) {
+    return (bits + 63) / 64;
+}
+
+size_t Align8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+}  // namespace
+
+TraceWriter::TraceWriter(std::vector<TraceChannel> channels)
+    : channels_(std::move(channels)), columns_(channels_.size()), timestamps_(kTraceBlockFrames) {
+    for (size_t i = 0; i < channels_.size(); ++i) {
+        const auto& channel = channels_[i];
+        columns_[i].presence_.resize(PresenceWords(kTraceBlockFrames * channel.slots_));
+        columns_[i].values_.resize(static_cast<size_t>(kTraceBlockFrames) * channel.slots_ * channel.values_per_slot_);
+    }
+}
+
+TraceWriter::~TraceWriter() {
+    static_cast<void>(Close());
+}
+
+absl::Status TraceWriter::Open(const std::string& path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        return absl::NotFoundError(absl::StrCat("cannot create trace ", path));
+    }
+    TraceFileHeader header{};
+    std::memcpy(header.magic_, kTraceMagic, sizeof(kTraceMagic));
+    header.version_ = kTraceVersion;
+    header.channel_count_ = static_cast<uint32_t>(channels_.size());
+    header.block_frames_ = kTraceBlockFrames;
+    auto status = Write(&header, sizeof(header));
+    for (const auto& channel : channels_) {
+        TraceChannelHeader channel_header{};
+        std::strncpy(channel_header.name_, channel.name_.c_str(), sizeof(channel_header.name_) - 1);
+        channel_header.kind_ = channel.kind_;
+        channel_header.slots_ = channel.slots_;
+        channel_header.values_per_slot_ = channel.values_per_slot_;
+        status.Update(Write(&channel_header, sizeof(channel_header)));
+    }
+    return status;
+}
+
+void TraceWriter::BeginFrame(int64_t timestamp_us) {
+    timestamps_[frame_count_] = timestamp_us;
+}
+
+float* TraceWriter::Slot(size_t channel, unsigned slot) {
+    const auto& info = channels_[channel];
+    auto& column = columns_[channel];
+    auto bit = static_cast<size_t>(frame_count_) * info.slots_ + slot;
+    column.presence_[bit / 64] |= uint64_t{1} << (bit % 64);
+    return column.values_.data() + bit * info.values_per_slot_;
+}
+
+absl::Status TraceWriter::EndFrame() {
+    if (++frame_count_ < kTraceBlockFrames) {
+        return absl::OkStatus();
+    }
+    return Flush();
+}
+
+absl::Status TraceWriter::Close() {
+    if (!file_) {
+        return absl::OkStatus();
+    }
+    auto status = Flush();
+    if (std::fclose(file_) != 0 && status.ok()) {
+        status = absl::InternalError("cannot close trace");
+    }
+    file_ = nullptr;
+    return status;
+}
+
+absl::Status TraceWriter::Write(const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file_) != size) {
+        return absl::InternalError("cannot write trace");
+    }
+    return absl::OkStatus();
+}
+
+absl::Status TraceWriter::Flush() {
+    if (frame_count_ == 0 || !file_) {
+        return absl::OkStatus();
+    }
+    TraceBlockHeader header{};
+    std::memcpy(header.magic_, kBlockMagic, sizeof(kBlockMagic));
+    header.frame_count_ = frame_count_;
+    header.size_ = sizeof(header) + sizeof(int64_t) * frame_count_;
+    for (const auto& channel : channels_) {
+        auto slots = static_cast<size_t>(frame_count_) * channel.slots_;
+        header.size_ += sizeof(uint64_t) * PresenceWords(slots) + Align8(sizeof(float) * slots * channel.values_per_slot_);
+    }
+    auto status = Write(&header, sizeof(header));
+    status.Update(Write(timestamps_.data(), sizeof(int64_t) * frame_count_));
+    const uint64_t padding = 0;
+    for (size_t i = 0; i < channels_.size(); ++i) {
+        auto slots = static_cast<size_t>(frame_count_) * channels_[i].slots_;
+        auto values_size = sizeof(float) * slots * channels_[i].values_per_slot_;
+        auto& column = columns_[i];
+        status.Update(Write(column.presence_.data(), sizeof(uint64_t) * PresenceWords(slots)));
+        status.Update(Write(column.values_.data(), values_size));
+        status.Update(Write(&padding, Align8(values_size) - values_size));
+        // Absent slots of the next block must read as zero.
+        std::fill(column.presence_.begin(), column.presence_.end(), 0);
+        std::fill(column.values_.begin(), column.values_.begin() + slots * channels_[i].values_per_slot_, 0.f);
+    }
+    frame_count_ = 0;
+    if (status.ok() && std::fflush(file_) != 0) {
+        status = absl::InternalError("cannot write trace");
+    }
+    return status;
+}
+
+TraceReader::~TraceReader() {
+#ifdef _WIN32
+    if (data_) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_) {
+        CloseHandle(mapping_);
+    }
+    if (file_) {
+        CloseHandle(file_);
+    }
+#else
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+absl::Status TraceReader::Open(const std::string& path) {
+#ifdef _WIN32
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        return absl::NotFoundError(absl::StrCat("cannot open trace ", path));
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_, &file_size)) {
+        return absl::InternalError(absl::StrCat("cannot read trace ", path));
+    }
+    size_ = static_cast<size_t>(file_size.QuadPart);
+    if (size_ > 0) {
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data_ = mapping_ ? static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data_) {
+            return absl::InternalError(absl::StrCat("cannot map trace ", path));
+        }
+    }
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return absl::NotFoundError(absl::StrCat("cannot open trace ", path));
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        return absl::InternalError(absl::StrCat("cannot read trace ", path));
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return absl::InternalError(absl::StrCat("cannot map trace ", path));
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+#endif
+
+    TraceFileHeader header;
+    if (size_ < sizeof(header)) {
+        return absl::InvalidArgumentError(absl::StrCat(path, " is not a trace"));
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic_, kTraceMagic, sizeof(kTraceMagic)) != 0 || header.version_ != kTraceVersion) {
+        return absl::InvalidArgumentError(absl::StrCat(path, " is not a version ", kTraceVersion, " trace"));
+    }
+    size_t offset = sizeof(header);
+    if (header.channel_count_ > (size_ - offset) / sizeof(TraceChannelHeader)) {
+        return absl::InvalidArgumentError(absl::StrCat(path, " has a truncated header"));
+    }
+    channels_.resize(header.channel_count_);
+    std::memcpy(channels_.data(), data_ + offset, sizeof(TraceChannelHeader) * channels_.size());
+    offset += sizeof(TraceChannelHeader) * channels_.size();
+
+    while (size_ - offset >= sizeof(TraceBlockHeader)) {
+        TraceBlockHeader block_header;
+        std::memcpy(&block_header, data_ + offset, sizeof(block_header));
+        if (std::memcmp(block_header.magic_, kBlockMagic, sizeof(kBlockMagic)) != 0 ||
+            block_header.size_ > size_ - offset || block_header.frame_count_ == 0) {
+            break;
+        }
+        Block block{frame_count_, block_header.frame_count_, nullptr, {}, {}};
+        size_t position = offset + sizeof(block_header);
+        block.timestamps_ = reinterpret_cast<const int64_t*>(data_ + position);
+        position += sizeof(int64_t) * block.frame_count_;
+        for (const auto& channel : channels_) {
+            auto slots = static_cast<size_t>(block.frame_count_) * channel.slots_;
+            block.presence_.push_back(reinterpret_cast<const uint64_t*>(data_ + position));
+            position += sizeof(uint64_t) * PresenceWords(slots);
+            block.values_.push_back(reinterpret_cast<const float*>(data_ + position));
+            position += Align8(sizeof(float) * slots * channel.values_per_slot_);
+        }
+        if (position != offset + block_header.size_) {
+            break;
+        }
+        frame_count_ += block.frame_count_;
+        blocks_.push_back(std::move(block));
+        offset = position;
+    }
+    return absl::OkStatus();
+}
+
+MpTraceInfo TraceReader::Info() const {
+    MpTraceInfo info{};
+    info.frame_count_ = frame_count_;
+    info.channel_count_ = static_cast<unsigned>(channels_.size());
+    if (!blocks_.empty()) {
+        info.first_timestamp_us_ = blocks_.front().timestamps_[0];
+        info.last_timestamp_us_ = blocks_.back().timestamps_[blocks_.back().frame_count_ - 1];
+    }
+    return info;
+}
+
+absl::Status TraceReader::CheckChannel(unsigned channel) const {
+    if (channel >= channels_.size()) {
+        return absl::InvalidArgumentError(absl::StrCat("no trace channel ", channel));
+    }
+    return absl::OkStatus();
+}
+
+absl::Status TraceReader::Channel(unsigned channel, MpTraceChannel* info) const {
+    auto status = CheckChannel(channel);
+    if (!status.ok()) {
+        return status;
+    }
+    const auto& header = channels_[channel];
+    std::memcpy(info->name_, header.name_, sizeof(info->name_));
+    info->name_[sizeof(info->name_) - 1] = '\0';
+    info->kind_ = static_cast<MpTraceChannelKind>(header.kind_);
+    info->slots_ = header.slots_;
+    info->values_per_slot_ = header.values_per_slot_;
+    return absl::OkStatus();
+}
+
+absl::Status TraceReader::Find(int64_t timestamp_us, uint64_t* index) const {
+    // Timestamps increase strictly, so both levels are binary searches.
+    auto block = std::partition_point(blocks_.begin(), blocks_.end(), [timestamp_us](const Block& block) {
+        return block.timestamps_[block.frame_count_ - 1] < timestamp_us;
+    });
+    if (block == blocks_.end()) {
+        return absl::NotFoundError(absl::StrCat("no frame at or after ", timestamp_us));
+    }
+    auto frame = std::lower_bound(block->timestamps_, block->timestamps_ + block->frame_count_, timestamp_us);
+    *index = block->first_frame_ + (frame - block->timestamps_);
+    return absl::OkStatus();
+}
+
+absl::Status TraceReader::Locate(uint64_t index, const Block** block, uint32_t* offset) const {
+    if (index >= frame_count_) {
+        return absl::InvalidArgumentError(absl::StrCat("no trace frame ", index));
+    }
+    auto found = std::partition_point(blocks_.begin(), blocks_.end(), [index](const Block& block) {
+        return block.first_frame_ + block.frame_count_ <= index;
+    });
+    *block = &*found;
+    *offset = static_cast<uint32_t>(index - found->first_frame_);
+    return absl::OkStatus();
+}
+
+absl::Status TraceReader::Timestamp(uint64_t index, int64_t* timestamp_us) const {
+    const Block* block;
+    uint32_t offset;
+    auto status = Locate(index, &block, &offset);
+    if (status.ok()) {
+        *timestamp_us = block->timestamps_[offset];
+    }
+    return status;
+}
+
+absl::Status TraceReader::Values(uint64_t index, unsigned channel, unsigned slot, const float** values) const {
+    auto status = CheckChannel(channel);
+    if (status.ok() && slot >= channels_[channel].slots_) {
+        status = absl::InvalidArgumentError(absl::StrCat("no slot ", slot, " in trace channel ", channel));
+    }
+    const Block* block;
+    uint32_t offset;
+    if (status.ok()) {
+        status = Locate(index, &block, &offset);
+    }
+    if (!status.ok()) {
+        return status;
+    }
+    const auto& header = channels_[channel];
+    auto bit = static_cast<size_t>(offset) * header.slots_ + slot;
+    auto present = (block->presence_[channel][bit / 64] >> (bit % 64)) & 1;
+    *values = present ? block->values_[channel] + bit * header.values_per_slot_ : nullptr;
+    return absl::OkStatus();
+}
+
+absl::Status TraceReader::Column(uint64_t index, unsigned channel, const int64_t** timestamps, const float** values,
+                                 uint64_t* count) const {
+    auto status = CheckChannel(channel);
+    const Block* block;
+    uint32_t offset;
+    if (status.ok()) {
+        status = Locate(index, &block, &offset);
+    }
+    if (!status.ok()) {
+        return status;
+    }
+    const auto& header = channels_[channel];
+    *timestamps = block->timestamps_ + offset;
+    *values = block->values_[channel] + static_cast<size_t>(offset) * header.slots_ * header.values_per_slot_;
+    *count = block->frame_count_ - offset;
+    return absl::OkStatus();
+}
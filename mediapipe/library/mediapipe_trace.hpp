@@ -0,0 +1,132 @@
+#ifndef MEDIAPIPE_TRACE_HPP_
+#define MEDIAPIPE_TRACE_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mediapipe_struct.h"
+#include "absl/status/status.h"
+
+// Append-only, columnar trace of per-frame results. Frames are grouped into
+// blocks of up to kTraceBlockFrames; within a block every channel is one
+// fixed-stride float array, so a reader maps the file and indexes it
+// directly. Everything is 8-byte aligned and in host byte order.
+//
+//   header:  char magic[4] = "MPTR", uint32 version, uint32 channel_count,
+//            uint32 block_frames, then channel_count TraceChannelHeader
+//   block:   TraceBlockHeader, int64 timestamps[frame_count], then per
+//            channel uint64 presence[ceil(frame_count * slots / 64)] and
+//            float values[frame_count * slots * values_per_slot], padded to
+//            8 bytes
+//
+// Bit frame * slots + slot of a channel's presence words tells whether that
+// slot held a result; absent slots are zero. A landmark channel stores each
+// landmark as the five floats of NormalizedLandmark.
+constexpr uint32_t kTraceVersion = 1;
+constexpr uint32_t kTraceBlockFrames = 256;
+
+struct TraceChannel {
+    std::string name_;
+    MpTraceChannelKind kind_;
+    unsigned slots_;
+    unsigned values_per_slot_;
+};
+
+struct TraceChannelHeader {
+    char name_[32];
+    uint32_t kind_;
+    uint32_t slots_;
+    uint32_t values_per_slot_;
+    uint32_t reserved_;
+};
+
+struct TraceBlockHeader {
+    char magic_[4];
+    uint32_t frame_count_;
+    // Size of the block including this header.
+    uint64_t size_;
+};
+
+// Buffers one block of frames and appends it to the file when full. Calls
+// must not overlap, which holds for the observer of one stream.
+class TraceWriter {
+public:
+    explicit TraceWriter(std::vector<TraceChannel> channels);
+    ~TraceWriter();
+
+    absl::Status Open(const std::string& path);
+    // Starts a frame in which every slot is absent until Slot is called.
+    void BeginFrame(int64_t timestamp_us);
+    // Marks slot of channel present in the current frame and returns its
+    // zeroed values.
+    float* Slot(size_t channel, unsigned slot);
+    absl::Status EndFrame();
+    // Writes the pending frames and closes the file.
+    absl::Status Close();
+
+private:
+    struct Column {
+        std::vector<uint64_t> presence_;
+        std::vector<float> values_;
+    };
+
+    absl::Status Write(const void* data, size_t size);
+    absl::Status Flush();
+
+    std::vector<TraceChannel> channels_;
+    std::vector<Column> columns_;
+    std::vector<int64_t> timestamps_;
+    uint32_t frame_count_{0};
+    std::FILE* file_{nullptr};
+};
+
+// Read-only view of a trace file, mapped into memory. Blocks are indexed when
+// the file is opened; a block cut short by a crash is ignored.
+class TraceReader {
+public:
+    TraceReader() = default;
+    ~TraceReader();
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    absl::Status Open(const std::string& path);
+
+    MpTraceInfo Info() const;
+    absl::Status Channel(unsigned channel, MpTraceChannel* info) const;
+    // Index of the first frame at or after timestamp_us.
+    absl::Status Find(int64_t timestamp_us, uint64_t* index) const;
+    absl::Status Timestamp(uint64_t index, int64_t* timestamp_us) const;
+    // Points values at the slot, or at null when the slot was absent.
+    absl::Status Values(uint64_t index, unsigned channel, unsigned slot, const float** values) const;
+    // Points at the run of frames from index to the end of its block: count
+    // timestamps, and count * slots * values_per_slot floats of channel.
+    absl::Status Column(uint64_t index, unsigned channel, const int64_t** timestamps, const float** values,
+                        uint64_t* count) const;
+
+private:
+    struct Block {
+        uint64_t first_frame_;
+        uint32_t frame_count_;
+        const int64_t* timestamps_;
+        // Per channel.
+        std::vector<const uint64_t*> presence_;
+        std::vector<const float*> values_;
+    };
+
+    absl::Status Locate(uint64_t index, const Block** block, uint32_t* offset) const;
+    absl::Status CheckChannel(unsigned channel) const;
+
+    const char* data_{nullptr};
+    size_t size_{0};
+#ifdef _WIN32
+    void* file_{nullptr};
+    void* mapping_{nullptr};
+#endif
+    std::vector<TraceChannelHeader> channels_;
+    std::vector<Block> blocks_;
+    uint64_t frame_count_{0};
+};
+
+#endif
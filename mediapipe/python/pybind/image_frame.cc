@@ -42,6 +42,9 @@ void ImageFrameSubmodule(pybind11::module* module) {
   SBGRA: sBGRA, interleaved: one byte for B, one byte for G, one byte for R, one
     byte for alpha or unused.
 
+  SBGR: sBGR, interleaved: one byte for B, then one byte for G, then one byte
+    for R for each pixel.
+
   GRAY8: Grayscale, one byte per pixel.
 
   GRAY16: Grayscale, one uint16 per pixel.
@@ -58,6 +61,7 @@ void ImageFrameSubmodule(pybind11::module* module) {
   image_format.value("SRGB", mediapipe::ImageFormat::SRGB)
       .value("SRGBA", mediapipe::ImageFormat::SRGBA)
       .value("SBGRA", mediapipe::ImageFormat::SBGRA)
+      .value("SBGR", mediapipe::ImageFormat::SBGR)
       .value("GRAY8", mediapipe::ImageFormat::GRAY8)
       .value("GRAY16", mediapipe::ImageFormat::GRAY16)
       .value("SRGB48", mediapipe::ImageFormat::SRGB48)
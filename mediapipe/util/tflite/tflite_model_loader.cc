@@ -14,6 +14,12 @@
 
 #include "mediapipe/util/tflite/tflite_model_loader.h"
 
+#include <map>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/util/resource_util.h"
 
@@ -21,13 +27,57 @@ namespace mediapipe {
 
 using FlatBufferModel = ::tflite_shims::FlatBufferModel;
 
-absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+namespace {
+
+absl::Mutex cache_mutex(absl::kConstInit);
+
+// Models that some packet still references, keyed by the requested path.
+std::map<std::string, std::weak_ptr<FlatBufferModel>>& ModelCache()
+    ABSL_EXCLUSIVE_LOCKS_REQUIRED(cache_mutex) {
+  static auto* cache = new std::map<std::string, std::weak_ptr<FlatBufferModel>>();
+  return *cache;
+}
+
+// Erases the entries of the models no packet references anymore.
+void PruneModelCache() ABSL_EXCLUSIVE_LOCKS_REQUIRED(cache_mutex) {
+  auto& cache = ModelCache();
+  for (auto it = cache.begin(); it != cache.end();) {
+    if (it->second.expired()) {
+      it = cache.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+// Maps the model file when path names one on disk, or returns null.
+std::shared_ptr<FlatBufferModel> MapModelFile(const std::string& path) {
+  std::vector<std::string> candidates = {path};
+  auto resolved_path = mediapipe::PathToResourceAsFile(path);
+  if (resolved_path.ok() && *resolved_path != path) {
+    candidates.push_back(*resolved_path);
+  }
+  for (const auto& candidate : candidates) {
+    if (!file::Exists(candidate).ok()) {
+      continue;
+    }
+    VLOG(2) << "Mapping the model from " << candidate;
+    auto model = FlatBufferModel::VerifyAndBuildFromFile(candidate.c_str());
+    if (model) {
+      return std::shared_ptr<FlatBufferModel>(std::move(model));
+    }
+  }
+  return nullptr;
+}
+
+// Reads the model through the resource loader into an owned blob.
+absl::StatusOr<std::shared_ptr<FlatBufferModel>> ReadModel(
     const std::string& path) {
   std::string model_path = path;
 
-  std::string model_blob;
+  auto model_blob = std::make_shared<std::string>();
   auto status_or_content =
-      mediapipe::GetResourceContents(model_path, &model_blob);
+      mediapipe::GetResourceContents(model_path, model_blob.get());
   // TODO: get rid of manual resolving with PathToResourceAsFile
   // as soon as it's incorporated into GetResourceContents.
   if (!status_or_content.ok()) {
@@ -35,18 +85,53 @@ absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
                      mediapipe::PathToResourceAsFile(model_path));
     VLOG(2) << "Loading the model from " << resolved_path;
     MP_RETURN_IF_ERROR(
-        mediapipe::GetResourceContents(resolved_path, &model_blob));
+        mediapipe::GetResourceContents(resolved_path, model_blob.get()));
   }
 
-  auto model = FlatBufferModel::VerifyAndBuildFromBuffer(model_blob.data(),
-                                                         model_blob.size());
+  auto model = FlatBufferModel::VerifyAndBuildFromBuffer(model_blob->data(),
+                                                         model_blob->size());
   RET_CHECK(model) << "Failed to load model from path " << model_path;
-  return api2::MakePacket<TfLiteModelPtr>(
-      model.release(),
-      [model_blob = std::move(model_blob)](FlatBufferModel* model) {
+  return std::shared_ptr<FlatBufferModel>(
+      model.release(), [model_blob](FlatBufferModel* released_model) {
         // It's required that model_blob is deleted only after
         // model is deleted, hence capturing model_blob.
-        delete model;
+        delete released_model;
+      });
+}
+
+}  // namespace
+
+absl::StatusOr<api2::Packet<TfLiteModelPtr>> TfLiteModelLoader::LoadFromPath(
+    const std::string& path) {
+  std::shared_ptr<FlatBufferModel> model;
+  {
+    absl::MutexLock lock(&cache_mutex);
+    auto it = ModelCache().find(path);
+    if (it != ModelCache().end()) {
+      model = it->second.lock();
+    }
+  }
+  if (!model) {
+    // Loaded without the lock, so that loading one model does not hold up
+    // the others. Graphs loading the same path at once may each read it, and
+    // then all use the one cached first.
+    std::shared_ptr<FlatBufferModel> loaded = MapModelFile(path);
+    if (!loaded) {
+      ASSIGN_OR_RETURN(loaded, ReadModel(path));
+    }
+    absl::MutexLock lock(&cache_mutex);
+    PruneModelCache();
+    auto& cached = ModelCache()[path];
+    model = cached.lock();
+    if (!model) {
+      model = std::move(loaded);
+      cached = model;
+    }
+  }
+  return api2::MakePacket<TfLiteModelPtr>(
+      model.get(), [model](FlatBufferModel*) mutable {
+        // Drops this packet's reference; the last one frees the model.
+        model.reset();
       });
 }
 
@@ -34,6 +34,13 @@ class TfLiteModelLoader {
  public:
   // Returns a Packet containing a TfLiteModelPtr, pointing to a model loaded
   // from the specified file path.
+  //
+  // Models are cached process-wide by path: every caller asking for a path
+  // whose model is still referenced by some packet shares that model, which
+  // is immutable and safe to use from several interpreters at once. Models
+  // backed by a file are memory-mapped where the platform allows it, so the
+  // weights stay in the page cache instead of on the heap. A model is freed
+  // once the last packet referencing it is destroyed.
   static absl::StatusOr<api2::Packet<TfLiteModelPtr>> LoadFromPath(
       const std::string& path);
 };